@@ -0,0 +1,78 @@
+#include <vector>
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+
+#include "circuit/circuit_utils.h"
+#include "libgarble/garble.h"
+#include "libgarble/circuit_builder.h"
+#include "libgarble/garbled_info.h"
+
+/* Compares hamming distance circuits summed with the compressor tree of
+ * popcount against the pairwise adder tree of popcountPairwise, giving the
+ * number of non-free gates and the time to garble and evaluate each, for
+ * 1000, 10000 and 100000 bit inputs.
+ */
+
+typedef void (*Popcount)(garble_circuit *, garble_context *, int *, int *, int);
+
+static void run(const char *name, Popcount count, int len) {
+  garble_circuit gc;
+  garble_context context;
+  int n = 2 * len, m = ceilLog2(len + 1);
+  std::vector<int> inp(n), diffs(len), outputs(m);
+
+  garble_new(&gc, n, m, GARBLE_TYPE_HALFGATES);
+  builder_init_wires(inp.data(), n);
+  builder_start_building(&gc, &context);
+  for (int i = 0; i < len; i++) {
+    diffs[i] = gateXOR(&gc, &context, inp[i], inp[i + len]);
+  }
+  count(&gc, &context, diffs.data(), outputs.data(), len);
+  builder_finish_building(&gc, &context, outputs.data());
+
+  auto t1 = std::chrono::high_resolution_clock::now();
+  garble_garble(&gc, NULL, NULL);
+  auto t2 = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::milli> garbling = t2 - t1;
+
+  std::vector<block> labels(n);
+  std::vector<bool> input(n);
+  int expected = 0;
+  for (int i = 0; i < n; i++) {
+    input[i] = rand() % 2;
+    labels[i] = gc.wires[2 * i + input[i]];
+  }
+  for (int i = 0; i < len; i++) {
+    expected += input[i] != input[i + len];
+  }
+
+  bool out[64];
+  t1 = std::chrono::high_resolution_clock::now();
+  garble_eval(&gc, labels.data(), NULL, out);
+  t2 = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::milli> evaluation = t2 - t1;
+
+  int distance = 0;
+  for (int i = m - 1; i >= 0; i--) {
+    distance = 2 * distance + out[i];
+  }
+
+  std::cout << name << " " << len << ": " << numNonXOR(&gc) << " non-XOR gates, garbled in "
+            << garbling.count() << " ms, evaluated in " << evaluation.count() << " ms";
+  if (distance != expected) {
+    std::cout << " (wrong distance)";
+  }
+  std::cout << std::endl;
+
+  garble_delete(&gc);
+}
+
+int main() {
+  for (int len: {1000, 10000, 100000}) {
+    run("pairwise  ", popcountPairwise, len);
+    run("compressor", popcount, len);
+  }
+
+  return 0;
+}
@@ -0,0 +1,60 @@
+#include <vector>
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+
+#include "pke/pke.h"
+
+/* Measures how many 16 byte circuit labels per second AES can encrypt, one
+ * label at a time with AES::Encrypt, and in bulk with AES::EncryptBatch, as
+ * done by SS::Encrypt. Takes the number of labels as an optional argument.
+ */
+
+int main(int argc, char *argv[]) {
+  size_t n = 100000;
+
+  if (argc > 1) {
+    n = std::stoul(argv[1]);
+  }
+
+  std::vector<AES::PublicKey> keys;
+  std::vector<const AES::PublicKey *> pks(n);
+  std::vector<AES::PlainText> msgs(n, AES::PlainText(16));
+
+  for (size_t i = 0; i < n; i++) {
+    keys.push_back(AES::Setup(AES_DEFAULT_KEYLENGTH).pk);
+    for (auto &byte: msgs[i]) {
+      byte = rand() % 256;
+    }
+  }
+
+  for (size_t i = 0; i < n; i++) {
+    pks[i] = &keys[i];
+  }
+
+  std::vector<AES::CipherText> cts(n);
+
+  auto t1 = std::chrono::high_resolution_clock::now();
+  for (size_t i = 0; i < n; i++) {
+    cts[i] = AES::Encrypt(keys[i], msgs[i]);
+  }
+  auto t2 = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double> single = t2 - t1;
+
+  t1 = std::chrono::high_resolution_clock::now();
+  AES::EncryptBatch(pks.data(), msgs.data(), cts.data(), n);
+  t2 = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double> batch = t2 - t1;
+
+  for (size_t i = 0; i < n; i++) {
+    if (AES::Decrypt(keys[i], cts[i]) != msgs[i]) {
+      std::cerr << "Batch encryption of label " << i << " does not decrypt." << std::endl;
+      return 1;
+    }
+  }
+
+  std::cout << "AES::Encrypt: " << n / single.count() << " labels/s" << std::endl;
+  std::cout << "AES::EncryptBatch: " << n / batch.count() << " labels/s" << std::endl;
+
+  return 0;
+}
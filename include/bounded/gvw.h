@@ -14,6 +14,7 @@ class GVW {
 private:
   int key_limit, depth, secret_shares, total_shares, delta_size, delta_pool_size;
   OneQS *oneqfe;
+  CircuitDescription *oneqfeDescription;
   bool useDelta;
 
 public:
@@ -40,12 +41,16 @@ public:
     MasterPublicKey pk;
   };
 
+  // Every key in sks is for the same circuit, so their bits are packed once, after Gamma and Delta. Keys packed
+  // with the bits of every key in sks are still read.
   struct SecretKey {
     std::vector<long> Gamma; // size secret_shares * depth + 1
     std::vector<int> Delta; // size v
     std::vector<typename OneQS::SecretKey> sks; // size secret_shares * depth+ 1
 
-    MSGPACK_DEFINE(Gamma, Delta, sks);
+    template <typename Packer> inline void msgpack_pack(Packer& pk) const;
+
+    inline void msgpack_unpack(msgpack::object const& o);
   };
 
   struct CipherText {
@@ -57,12 +62,13 @@ public:
     MSGPACK_DEFINE(cts);
   };
 
-  // Initialize parameters based as suggested by GVW.
-  GVW(int keys, int depth, int kappa, int modulus, bool useDelta, CircuitDescription *description);
+  // Initialize parameters based as suggested by GVW. threads, scheme and
+  // seededKeys are given to the SS instance of every share, as in SS.
+  GVW(int keys, int depth, int kappa, int modulus, bool useDelta, CircuitDescription *description, int threads = 1, GarblingScheme scheme = GARBLING_SCHEME_HALF_GATES, bool seededKeys = false);
 
   // Initialize concrete values of secret_shares, total_shares, delta_size,
   // delta_pool_size
-  GVW(int keys, int depth, int secret_shares, int total_shares, int delta_size, int delta_pool_size, int modulus, bool useDelta, CircuitDescription *description);
+  GVW(int keys, int depth, int secret_shares, int total_shares, int delta_size, int delta_pool_size, int modulus, bool useDelta, CircuitDescription *description, int threads = 1, GarblingScheme scheme = GARBLING_SCHEME_HALF_GATES, bool seededKeys = false);
 
   KeyPair Setup(int length);
 
@@ -70,12 +76,61 @@ public:
 
   CipherText Encrypt(MasterPublicKey mpk, std::vector<int> msg);
 
-  std::vector<int> Decrypt(SecretKey sk, CipherText ct);
+  std::vector<int> Decrypt(const SecretKey &sk, const CipherText &ct);
+
+  // Gives the circuit description the SS instance of every share garbles, which also adds Delta when useDelta is set.
+  CircuitDescription *oneQueryCircuitDescription() {
+    return oneqfeDescription;
+  };
+};
+
+template<class OneQS> template <typename Packer>
+void GVW<OneQS>::SecretKey::msgpack_pack(Packer& pk) const {
+  pk.pack_array(4);
+
+  pk.pack(Gamma);
+  pk.pack(Delta);
+  if (sks.empty()) {
+    pk.pack_bin(0);
+  } else {
+    sks[0].packBits(pk);
+  }
+
+  pk.pack_array(sks.size());
+  for (size_t i = 0; i < sks.size(); i++) {
+    sks[i].packKeys(pk);
+  }
+};
+
+template<class OneQS>
+void GVW<OneQS>::SecretKey::msgpack_unpack(msgpack::object const& o) {
+  if (o.type != msgpack::type::ARRAY || (o.via.array.size != 3 && o.via.array.size != 4)) {
+    throw msgpack::type_error();
+  }
+
+  o.via.array.ptr[0].convert(Gamma);
+  o.via.array.ptr[1].convert(Delta);
+
+  if (o.via.array.size == 3) {
+    o.via.array.ptr[2].convert(sks);
+    return;
+  }
+
+  const msgpack::object &keys = o.via.array.ptr[3];
+  if (keys.type != msgpack::type::ARRAY) { throw msgpack::type_error(); }
+
+  sks.resize(keys.via.array.size);
+  for (size_t i = 0; i < sks.size(); i++) {
+    sks[i].unpackKeys(keys.via.array.ptr[i]);
+    sks[i].unpackBits(o.via.array.ptr[2]);
+  }
 };
 
 typedef GVW<SS_AES> GVW_SS_AES;
 typedef GVW<SS_RSA> GVW_SS_RSA;
 typedef GVW<SS_SingletonAES> GVW_SS_SingletonAES;
 typedef GVW<SS_SingletonRSA> GVW_SS_SingletonRSA;
+typedef GVW<SS_ECC> GVW_SS_ECC;
+typedef GVW<SS_SingletonECC> GVW_SS_SingletonECC;
 
 #endif
@@ -61,7 +61,8 @@ public:
     MSGPACK_DEFINE(cts);
   };
 
-  StatefulFE(int keys, CircuitDescription *description);
+  // threads, scheme and seededKeys are given to every SS instance, as in SS.
+  StatefulFE(int keys, CircuitDescription *description, int threads = 1, GarblingScheme scheme = GARBLING_SCHEME_HALF_GATES, bool seededKeys = false);
 
   KeyPair Setup(int length);
 
@@ -69,12 +70,14 @@ public:
 
   CipherText Encrypt(MasterPublicKey mpk, std::vector<int> msg);
 
-  std::vector<int> Decrypt(SecretKey sk, CipherText ct);
+  std::vector<int> Decrypt(const SecretKey &sk, const CipherText &ct);
 };
 
 typedef StatefulFE<SS_AES> StatefulFE_AES;
 typedef StatefulFE<SS_RSA> StatefulFE_RSA;
 typedef StatefulFE<SS_SingletonAES> StatefulFE_SingletonAES;
 typedef StatefulFE<SS_SingletonRSA> StatefulFE_SingletonRSA;
+typedef StatefulFE<SS_ECC> StatefulFE_ECC;
+typedef StatefulFE<SS_SingletonECC> StatefulFE_SingletonECC;
 
 #endif
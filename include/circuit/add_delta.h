@@ -1,6 +1,8 @@
 #ifndef ADD_DELTA
 #define ADD_DELTA
 
+#include <vector>
+
 #include "libgarble/garble.h"
 #include "libgarble/circuit_builder.h"
 
@@ -9,4 +11,8 @@ void addDelta(garble_circuit *circuit, garble_context *garblingContext,
               int S, int* existing, int* zetas, int* delta, int* outputs,
               int len, int p);
 
+// As addDelta, but adds the selected values to the unreduced sum without reducing modulo p.
+void addDeltaUnreduced(garble_circuit *circuit, garble_context *garblingContext,
+              int S, std::vector<int> &sum, int* zetas, int* delta, int len);
+
 #endif
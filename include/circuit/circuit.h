@@ -3,11 +3,18 @@
 
 #include <vector>
 #include <cmath>
+#include <cstring>
+#include <cstdlib>
 #include <algorithm>
+#include <mutex>
+#include <stdexcept>
 
 #include "libgarble/garble.h"
 #include "libgarble/circuit_builder.h"
 
+#include "circuit/circuit_statistics.h"
+#include "circuit/wire_slots.h"
+
 // Types of supported circuits.
 typedef enum {
   CIRCUIT_TYPE_PARITY,
@@ -15,6 +22,7 @@ typedef enum {
   CIRCUIT_TYPE_INNER_PRODUCT_MOD_P_DELTA,
   CIRCUIT_TYPE_HAMMING,
   CIRCUIT_TYPE_LEVENSHTEIN,
+  CIRCUIT_TYPE_BANDED_LEVENSHTEIN,
 } CircuitType;
 
 // Generic structure of a Circuit Description. This describes 
@@ -45,8 +53,94 @@ class CircuitDescription {
   // Turns the message to binary to input into the circuit.
   virtual int msgBit(std::vector<int> &msg, int i) = 0;
 
-  // Creates a universal circuit based on the circuit description.
+  CircuitDescription() {};
+
+  virtual ~CircuitDescription() {
+    if (topologyBuilt) {
+      garble_delete(&topology);
+    }
+    if (legacyTopologyBuilt) {
+      garble_delete(&legacyTopology);
+    }
+  };
+
+  // Creates a universal circuit based on the circuit description. The gates and output wires are copied from the cached topology, so the caller owns the circuit and may garble and garble_delete it.
   virtual void universalCircuit(garble_circuit *circuit) {
+    const garble_circuit *cached = universalCircuitTopology();
+
+    *circuit = *cached;
+
+    circuit->gates = (garble_gate *) malloc(cached->q * sizeof(garble_gate));
+    std::memcpy(circuit->gates, cached->gates, cached->q * sizeof(garble_gate));
+    circuit->outputs = (int *) malloc(cached->m * sizeof(int));
+    std::memcpy(circuit->outputs, cached->outputs, cached->m * sizeof(int));
+
+    circuit->wires = NULL;
+    circuit->table = NULL;
+    circuit->output_perms = NULL;
+  }
+
+  // Gives the gates, wire numbering and output wires of the universal circuit, which are built once and then shared by every garbling and evaluation. The result must not be modified or freed.
+  const garble_circuit *universalCircuitTopology() {
+    std::call_once(topologyFlag, [this]() {
+      GadgetRecorder recorder(gadgetStatistics);
+      buildUniversalCircuit(&topology);
+      topologyBuilt = true;
+    });
+
+    return &topology;
+  }
+
+  // Gives the universal circuit as it was built before the gadgets were reworked, which version 0 garbled tables were
+  // garbled over. It is built once and cached like the topology.
+  const garble_circuit *legacyUniversalCircuitTopology() {
+    std::call_once(legacyTopologyFlag, [this]() {
+      buildCircuit(&legacyTopology, &CircuitDescription::fillLegacyUniversalCircuit);
+      legacyTopologyBuilt = true;
+    });
+
+    return &legacyTopology;
+  }
+
+  // Gives the slots for the wire labels of the universal circuit during evaluation, which are assigned once and then
+  // shared like the topology.
+  const WireSlots &universalCircuitWireSlots() {
+    std::call_once(wireSlotsFlag, [this]() {
+      assignWireSlots(universalCircuitTopology(), wireSlots);
+    });
+
+    return wireSlots;
+  }
+
+  // Gives the gate counts, wire count, multiplicative depth and per-gadget breakdown of the universal circuit. This
+  // only builds the circuit, and shares the cached topology, so needs no garbling.
+  CircuitStatistics statistics() {
+    const garble_circuit *circuit = universalCircuitTopology();
+    CircuitStatistics stats = gadgetStatistics;
+    countGates(circuit, stats);
+
+    return stats;
+  }
+
+  // Builds the universal circuit from scratch.
+  virtual void buildUniversalCircuit(garble_circuit *circuit) {
+    buildCircuit(circuit, &CircuitDescription::fillUniversalCircuit);
+  }
+
+  // Circuit description type dependent universal circuit creation.
+  virtual void fillUniversalCircuit(garble_circuit *circuit, garble_context *context, std::vector<int> inputs, std::vector<int> &outputs) = 0;
+
+  // Circuit description type dependent legacy universal circuit creation. Only the circuits that existed before the
+  // gadgets were reworked have one.
+  virtual void fillLegacyUniversalCircuit(garble_circuit *, garble_context *, std::vector<int>, std::vector<int> &) {
+    throw std::runtime_error("This type of circuit has no legacy universal circuit, so has no version 0 garbled tables.");
+  }
+
+ private:
+  typedef void (CircuitDescription::*FillFunction)(garble_circuit *, garble_context *, std::vector<int>, std::vector<int> &);
+
+  // Builds a universal circuit, with fill giving its core.
+  void buildCircuit(garble_circuit *circuit, FillFunction fill) {
     garble_context context;
 
     int n = input_size + circuit_size;
@@ -62,13 +156,32 @@ class CircuitDescription {
     builder_start_building(circuit, &context);
 
     // The core of the universal circuit is dependent on the type of circuit description.
-    fillUniversalCircuit(circuit, &context, inp, outputs);
+    try {
+      (this->*fill)(circuit, &context, inp, outputs);
+    } catch (...) {
+      garble_delete(circuit);
+      throw;
+    }
 
     builder_finish_building(circuit, &context, outputs.data());
   }
 
-  // Circuit description type dependent universal circuit creation.
-  virtual void fillUniversalCircuit(garble_circuit *circuit, garble_context *context, std::vector<int> inputs, std::vector<int> &outputs) = 0;
+  // Cached universal circuit, without any garbling.
+  garble_circuit topology;
+  bool topologyBuilt = false;
+  std::once_flag topologyFlag;
+
+  // Cached legacy universal circuit, only built for version 0 garbled tables.
+  garble_circuit legacyTopology;
+  bool legacyTopologyBuilt = false;
+  std::once_flag legacyTopologyFlag;
+
+  // Cached slots for evaluating the universal circuit.
+  WireSlots wireSlots;
+  std::once_flag wireSlotsFlag;
+
+  // Gadget breakdown recorded while building the cached topology.
+  CircuitStatistics gadgetStatistics;
 };
 
 // Parity circuits, ie inner product over F_2.
@@ -95,6 +208,7 @@ class ParityCircuitDescription : public CircuitDescription {
   }
 
   virtual void fillUniversalCircuit(garble_circuit *circuit, garble_context *context, std::vector<int> inputs, std::vector<int> &outputs);
+  virtual void fillLegacyUniversalCircuit(garble_circuit *circuit, garble_context *context, std::vector<int> inputs, std::vector<int> &outputs);
 };
 
 // Circuits for inner product over F_p, for some prime p.
@@ -135,6 +249,7 @@ class InnerProductModPCircuitDescription : public CircuitDescription {
   }
 
   virtual void fillUniversalCircuit(garble_circuit *circuit, garble_context *context, std::vector<int> inputs, std::vector<int> &outputs);
+  virtual void fillLegacyUniversalCircuit(garble_circuit *circuit, garble_context *context, std::vector<int> inputs, std::vector<int> &outputs);
 };
 
 // Circuits for inner product over F_p for prime p, with the added Delta as used in the GVW bounded-collusion FE scheme.
@@ -152,6 +267,7 @@ class InnerProductModPDeltaCircuitDescription : public InnerProductModPCircuitDe
   };
 
   virtual void fillUniversalCircuit(garble_circuit *circuit, garble_context *context, std::vector<int> inputs, std::vector<int> &outputs);
+  virtual void fillLegacyUniversalCircuit(garble_circuit *circuit, garble_context *context, std::vector<int> inputs, std::vector<int> &outputs);
 };
 
 // Circuits for computing hamming distance.
@@ -178,6 +294,7 @@ class HammingCircuitDescription : public CircuitDescription {
   }
 
   virtual void fillUniversalCircuit(garble_circuit *circuit, garble_context *context, std::vector<int> inputs, std::vector<int> &outputs);
+  virtual void fillLegacyUniversalCircuit(garble_circuit *circuit, garble_context *context, std::vector<int> inputs, std::vector<int> &outputs);
 };
 
 // Circuits for computing levenshtein distance.
@@ -210,6 +327,21 @@ class LevenshteinCircuitDescription : public CircuitDescription {
   }
 
   virtual void fillUniversalCircuit(garble_circuit *circuit, garble_context *context, std::vector<int> inputs, std::vector<int> &outputs);
+  virtual void fillLegacyUniversalCircuit(garble_circuit *circuit, garble_context *context, std::vector<int> inputs, std::vector<int> &outputs);
+};
+
+// Circuits for computing levenshtein distance up to a threshold, which only look at the band of the table within threshold of the diagonal. Distances above the threshold are output as threshold + 1.
+class BandedLevenshteinCircuitDescription : public LevenshteinCircuitDescription {
+ public:
+  int threshold;
+
+  BandedLevenshteinCircuitDescription(int inputLen, int circuitLen, int alphabetBits, int threshold): LevenshteinCircuitDescription(inputLen, circuitLen, alphabetBits), threshold(threshold) {
+    type = CIRCUIT_TYPE_BANDED_LEVENSHTEIN;
+    output_size = (int) ceil(log2(threshold + 2));
+  };
+
+  virtual void fillUniversalCircuit(garble_circuit *circuit, garble_context *context, std::vector<int> inputs, std::vector<int> &outputs);
+  virtual void fillLegacyUniversalCircuit(garble_circuit *circuit, garble_context *context, std::vector<int> inputs, std::vector<int> &outputs);
 };
 
 // Details of a specific circuit. These correspond to circuit descriptions, but can be seen as an instance of a circuit described by the circuit description.
@@ -303,4 +435,12 @@ public:
   }
 };
 
+// Computes Levenshtein distance up to a threshold with the encoded message.
+class BandedLevenshteinCircuit : public LevenshteinCircuit {
+public:
+  BandedLevenshteinCircuit(std::vector<int> circuit, int inputLen, int alphabetBits): LevenshteinCircuit(circuit, inputLen, alphabetBits) {
+    type = CIRCUIT_TYPE_BANDED_LEVENSHTEIN;
+  };
+};
+
 #endif
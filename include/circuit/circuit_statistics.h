@@ -0,0 +1,78 @@
+#ifndef CIRCUIT_STATISTICS_H
+#define CIRCUIT_STATISTICS_H
+
+#include <map>
+#include <vector>
+#include <string>
+#include <ostream>
+#include <cstdint>
+
+#include "libgarble/garble.h"
+
+/* Gate, wire and depth accounting for circuits, which needs no garbling. Totals are read off the gates of a built
+ * circuit, and the breakdown by gadget is recorded while the circuit is being built, through the gate* builder layer
+ * of circuit_utils.h.
+ */
+
+// Gates added by one gadget, including those of the gadgets it calls, and the number of times it was called. A
+// gadget calling itself recursively is counted once.
+struct GadgetStatistics {
+  uint64_t calls = 0;
+  uint64_t andGates = 0, orGates = 0, xorGates = 0, notGates = 0;
+
+  // Gates that need a garbled table.
+  uint64_t nonXOR() const {
+    return andGates + orGates + notGates;
+  }
+};
+
+// Statistics for a whole circuit.
+struct CircuitStatistics {
+  uint64_t andGates = 0, orGates = 0, xorGates = 0, notGates = 0, constantGates = 0;
+  uint64_t wires = 0;
+
+  // Largest number of AND and OR gates on any path from an input to an output.
+  int multiplicativeDepth = 0;
+
+  // Keyed by gadget name. Gates added outside of any gadget are under "other". As gadgets include the gadgets they
+  // call, these overlap and do not add up to the totals.
+  std::map<std::string, GadgetStatistics> gadgets;
+
+  // Gates that need a garbled table, as counted by numNonXOR.
+  uint64_t nonXOR() const {
+    return andGates + orGates + notGates + constantGates;
+  }
+};
+
+// Fills in the gate counts, wire count and multiplicative depth of a built circuit. The gadget breakdown is left alone.
+void countGates(const garble_circuit *circuit, CircuitStatistics &stats);
+
+// Writes the statistics in the same "name: value" lines as the results file.
+std::ostream &operator<<(std::ostream &out, const CircuitStatistics &stats);
+
+// While alive, attributes the gates built on this thread to the gadget breakdown of stats.
+class GadgetRecorder {
+ public:
+  GadgetRecorder(CircuitStatistics &stats);
+  ~GadgetRecorder();
+
+ private:
+  CircuitStatistics *previous;
+  std::vector<GadgetStatistics *> previousGadgets;
+};
+
+// Counts the gates built on this thread while alive towards the named gadget. Does nothing unless a GadgetRecorder is
+// alive.
+class GadgetScope {
+ public:
+  GadgetScope(const char *name);
+  ~GadgetScope();
+
+ private:
+  bool pushed;
+};
+
+// Counts one gate of the given type towards the gadgets being built, if they are being recorded.
+void recordGate(garble_gate_type_e type);
+
+#endif
@@ -1,12 +1,33 @@
 #ifndef CIRCUIT_UTILS_H
 #define CIRCUIT_UTILS_H
 
+#include <vector>
+
 #include "libgarble/garble.h"
 #include "libgarble/circuit_builder.h"
 
 /* These methods add specific functions to a circuit.
  */
 
+// Width below which the Karatsuba multipliers fall back to schoolbook multiplication.
+#ifndef KARATSUBA_CUTOFF
+#define KARATSUBA_CUTOFF 16
+#endif
+
+// Width from which innerProductGF2NCircuit uses multiplyGF2NKaratsuba.
+#ifndef KARATSUBA_GF2N_MIN_BITS
+#define KARATSUBA_GF2N_MIN_BITS 2
+#endif
+
+// Builder layer: adds a gate to the circuit and returns its output wire. Gates whose output is already known (constant
+// inputs, or both inputs on the same wire) are folded instead, and an existing wire is returned, so constants always
+// stay on wire_zero/wire_one and gates on them never reach the garbled circuit. Gadgets should build through these
+// rather than through gate_AND and friends.
+int gateAND(garble_circuit *circuit, garble_context *context, int in0, int in1);
+int gateXOR(garble_circuit *circuit, garble_context *context, int in0, int in1);
+int gateOR(garble_circuit *circuit, garble_context *context, int in0, int in1);
+int gateNOT(garble_circuit *circuit, garble_context *context, int in);
+
 // if decider wire has a 1, first input, else second input, for length len inputs
 void mux(garble_circuit *circuit, garble_context *context,
            int *in1, int *in2, int deciderWire, int *out, int len);
@@ -23,6 +44,10 @@ void gteq(garble_circuit *circuit, garble_context *context,
 void min(garble_circuit *circuit, garble_context *context,
          int *in1, int *in2, int *out, int* minimal, int len);
 
+// Sets sum and carryOut to the sum of three bits, with a single AND gate.
+void fullAdder(garble_circuit *circuit, garble_context *context,
+               int in1, int in2, int carryIn, int *sum, int *carryOut);
+
 // Out (length len + 1) is set to sum of length len numbers on in1 and in2
 void add(garble_circuit *circuit, garble_context *context,
          int* in1, int* in2, int* out, int len);
@@ -47,6 +72,29 @@ void multiplyBy2ModP(garble_circuit *circuit, garble_context *context,
 void multiplyModP(garble_circuit *circuit, garble_context *context,
                int* in1, int* in2, int *out, int len, int* p);
 
+// Reduces a number of inLen bits modulo p, for p of len bits, by one conditional subtraction of p * 2^s per shift s.
+void reduceWideModP(garble_circuit *circuit, garble_context *context,
+                    int *in, int inLen, int *out, int len, int *p);
+
+// Adds the len bits on in to the unreduced sum, which grows by at most one bit, and to at most maxLen bits, which the caller must know bounds the result.
+void accumulate(garble_circuit *circuit, garble_context *context,
+                std::vector<int> &sum, int *in, int len, int maxLen);
+
+// Smallest number of bits b such that 2^b >= x.
+int ceilLog2(int x);
+
+// Out (length 2 * len) is set to the product of the length len numbers on in1 and in2.
+void multiplySchoolbook(garble_circuit *circuit, garble_context *context,
+                        int *in1, int *in2, int *out, int len);
+
+// As multiplySchoolbook, but splits the inputs in half with Karatsuba's method, down to KARATSUBA_CUTOFF bits.
+void multiplyKaratsuba(garble_circuit *circuit, garble_context *context,
+                       int *in1, int *in2, int *out, int len);
+
+// Multiplies numbers modulo p, assumes inputs are reduced mod p, by taking the full product and reducing it once.
+void multiplyModPKaratsuba(garble_circuit *circuit, garble_context *context,
+               int* in1, int* in2, int *out, int len, int* p);
+
 // Add/subtract in GF(2^n).
 void addGF2N(garble_circuit *circuit, garble_context *context,
                int* in1, int* in2, int *out, int n);
@@ -59,6 +107,14 @@ void reduceGF2NByIrredPoly(garble_circuit *circuit, garble_context *context,
 void multiplyGF2N(garble_circuit *circuit, garble_context *context,
                int* in1, int* in2, int *out, int n, int *irredPoly);
 
+// Out (2n - 1 coefficients) is set to the product of the polynomials over GF(2) with n coefficients on in1 and in2, using Karatsuba's method.
+void multiplyPolyGF2Karatsuba(garble_circuit *circuit, garble_context *context,
+               int* in1, int* in2, int *out, int n);
+
+// As multiplyGF2N, but multiplies with multiplyPolyGF2Karatsuba and then reduces.
+void multiplyGF2NKaratsuba(garble_circuit *circuit, garble_context *context,
+               int* in1, int* in2, int *out, int n, int *irredPoly);
+
 // Add mod 2^32
 void add32(garble_circuit *circuit, garble_context *context,
                int* in1, int* in2, int *out);
@@ -67,6 +123,23 @@ void add32(garble_circuit *circuit, garble_context *context,
 void multiply32(garble_circuit *circuit, garble_context *context,
                int* in1, int* in2, int *out);
 
+// Out (length len) is set to the product of in1 and in2 modulo 2^len, using Karatsuba's method for the low halves.
+void multiplyLowKaratsuba(garble_circuit *circuit, garble_context *context,
+               int* in1, int* in2, int *out, int len);
+
+// Multiply mod 2^32, with multiplyLowKaratsuba.
+void multiply32Karatsuba(garble_circuit *circuit, garble_context *context,
+               int* in1, int* in2, int *out);
+
+// Outputs the number of ones among the len input wires, on ceilLog2(len + 1) wires, with a tree of full adders
+// (3:2 compressors) and one final adder.
+void popcount(garble_circuit *circuit, garble_context *context,
+              int *in, int *out, int len);
+
+// As popcount, but adds the inputs up pairwise with a tree of ripple-carry adders.
+void popcountPairwise(garble_circuit *circuit, garble_context *context,
+              int *in, int *out, int len);
+
 // Outputs hamming distance between input1 and input2, of length len
 void hamming(garble_circuit *circuit, garble_context *context,
              int *in1, int *in2, int *out, int len);
@@ -76,4 +149,10 @@ void levenshteinCore(garble_circuit *circuit, garble_context *context,
                      std::vector<int> &xCand, std::vector<int> &yCand, std::vector<int> &diagCand,
                      int *in1, int *in2, std::vector<int> &out, int alphabetBits);
 
+// Levenshtein cell on differences between neighbouring cells, which are each -1, 0 or 1, encoded as {is 1, is -1}.
+// hIn is the cell above minus the diagonal cell, and vIn the cell on the left minus the diagonal cell; hOut is set
+// to the new cell minus the cell on the left, and vOut to the new cell minus the cell above.
+void levenshteinDiffCore(garble_circuit *circuit, garble_context *context,
+                         int *hIn, int *vIn, int neqWire, int *hOut, int *vOut);
+
 #endif
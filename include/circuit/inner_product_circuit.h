@@ -1,6 +1,8 @@
 #ifndef INNER_PRODUCT_CIRCUIT_H
 #define INNER_PRODUCT_CIRCUIT_H
 
+#include <vector>
+
 #include "libgarble/garble.h"
 #include "libgarble/circuit_builder.h"
 
@@ -10,6 +12,12 @@
 void innerProductCircuit(garble_circuit *circuit, garble_context *garblingContext, 
                   int n, int offset, int* inputs, int* outputs, int len, int p);
 
+/* As innerProductCircuit, but leaves the inner product over the integers on sum, which is resized to as many bits as the sum can need, without reducing it modulo p.
+*/
+
+void innerProductUnreducedCircuit(garble_circuit *circuit, garble_context *garblingContext,
+                  int n, int offset, int* inputs, std::vector<int> &sum, int len);
+
 /* Creates a circuit that finds the inner product over GF2N between the first and second half of the input wires (each vectors of n/len numbers, with len bits each), and put the output on the output wires (also a vector of n/len len-bit numbers). This also takes the irreducible polynomial for the representation of GF2N used.
 */
 
@@ -0,0 +1,27 @@
+#ifndef LEGACY_CIRCUIT_H
+#define LEGACY_CIRCUIT_H
+
+#include "libgarble/garble.h"
+#include "libgarble/circuit_builder.h"
+
+/* The universal circuits as they were built before the gadgets were reworked, gate for gate. Version 0 garbled tables
+ * were garbled over these, so they can only be evaluated against them. They must not be changed, even to fix them: the
+ * levenshtein circuit keeps its original initialisation of the first column.
+ */
+
+void legacyParityCircuit(garble_circuit *circuit, garble_context *garblingContext,
+                         int n, int* inputs, int* outputs);
+
+void legacyInnerProductCircuit(garble_circuit *circuit, garble_context *garblingContext,
+                               int n, int offset, int* inputs, int* outputs, int len, int p);
+
+void legacyAddDelta(garble_circuit *circuit, garble_context *garblingContext,
+                    int S, int* existing, int* zetas, int* delta, int* outputs, int len, int p);
+
+void legacyHammingCircuit(garble_circuit *circuit, garble_context *garblingContext,
+                          int n, int* inputs, int* outputs);
+
+void legacyLevenshteinCircuit(garble_circuit *circuit, garble_context *garblingContext,
+                              int *inputs, int *out, int len1, int len2, int alphabetBits);
+
+#endif
@@ -10,4 +10,16 @@
 void levenshteinCircuit(garble_circuit *circuit, garble_context *garblingContext, 
                         int *inputs, int *out, int len1, int len2, int alphabetBits);
 
+/* As levenshteinCircuit, but each cell only carries its differences to its neighbours, which are -1, 0 or 1, so every cell costs a constant number of gates whatever the lengths. The distance itself is only put together at the end, from the differences down the last column.
+ */
+
+void levenshteinDiffCircuit(garble_circuit *circuit, garble_context *garblingContext,
+                            int *inputs, int *out, int len1, int len2, int alphabetBits);
+
+/* As levenshteinCircuit, but only builds the cells within threshold of the diagonal, so it costs O(len1 * threshold) rather than O(len1 * len2). The output is the distance if it is at most threshold, and threshold + 1 otherwise, on ceil(log2(threshold + 2)) wires.
+ */
+
+void bandedLevenshteinCircuit(garble_circuit *circuit, garble_context *garblingContext,
+                              int *inputs, int *out, int len1, int len2, int alphabetBits, int threshold);
+
 #endif
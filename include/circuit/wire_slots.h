@@ -0,0 +1,23 @@
+#ifndef WIRE_SLOTS_H
+#define WIRE_SLOTS_H
+
+#include <vector>
+
+#include "libgarble/garble.h"
+
+/* Slots for the labels of a circuit's wires during evaluation. A wire hands its slot on to a later wire once it has
+ * been read for the last time, so evaluation holds one label per slot, bounded by the number of wires live at once,
+ * rather than one per wire.
+ */
+struct WireSlots {
+  // Slot of each wire. The n input wires are in slots 0 to n - 1, and output wires are never handed on.
+  std::vector<int> slots;
+
+  // Number of slots needed.
+  size_t count = 0;
+};
+
+// Assigns slots to the wires of a circuit, assuming its gates are in the order they are evaluated.
+void assignWireSlots(const garble_circuit *circuit, WireSlots &wireSlots);
+
+#endif
@@ -2,6 +2,8 @@
 #define GARBLED_INFO
 
 #include <vector>
+#include <cstring>
+#include <cstdint>
 #include <msgpack.hpp>
 
 #include "libgarble/garble.h"
@@ -18,8 +20,71 @@ inline uint64_t numNonXOR(garble_circuit *gc) {
   return n;
 }
 
+// Versions of GarbledInfo. Tables from libgarble's garble_garble have a row for every non-XOR gate and are evaluated
+// with garble_eval, after unpackTable. The first version only held libgarble half-gates tables, garbled from universal
+// circuits that have since been rebuilt, so they are evaluated against the legacy universal circuit of their
+// description. Later libgarble tables also give their garble_type_e, as the rows of each type differ in size. Tables
+// from halfGatesGarble only have rows for AND and OR gates, and are evaluated with halfGatesEval. They are written
+// either as the libgarble layout plus a version number, or in the compact encoding, a single binary blob:
+//
+//   16 byte header: version (uint32), number of output bits m (uint32), number of table blocks (uint64)
+//   fixed_label, global_key
+//   output permutation bits, packed 8 to a byte and padded to a multiple of 16 bytes
+//   table
+//
+// so every block lies at a multiple of 16 bytes from the start of the blob.
+#define GARBLED_INFO_VERSION_LIBGARBLE 0
+#define GARBLED_INFO_VERSION_HALF_GATES 1
+#define GARBLED_INFO_VERSION_COMPACT 2
+#define GARBLED_INFO_VERSION_LIBGARBLE_TYPED 3
+
+// Size of the header of the compact encoding.
+#define GARBLED_INFO_COMPACT_HEADER_SIZE 16
+
+// Ways to garble a circuit. The default is halfGatesGarble, and the rest use libgarble's garble_garble with the
+// matching garble_type_e, to compare table sizes and running times. Privacy-free garbling is left out, as it does
+// not hide the message from the evaluator.
+typedef enum {
+  GARBLING_SCHEME_HALF_GATES,
+  GARBLING_SCHEME_LIBGARBLE_STANDARD,
+  GARBLING_SCHEME_LIBGARBLE_HALF_GATES,
+} GarblingScheme;
+
+// Gives the libgarble type used by a scheme other than GARBLING_SCHEME_HALF_GATES.
+inline garble_type_e libgarbleType(GarblingScheme scheme) {
+  switch (scheme) {
+    case GARBLING_SCHEME_LIBGARBLE_STANDARD:
+      return GARBLE_TYPE_STANDARD;
+    default:
+      return GARBLE_TYPE_HALFGATES;
+  }
+}
+
+// Gives the number of blocks in the table of a circuit garbled with the given scheme.
+inline uint64_t garbledTableBlocks(const garble_circuit *gc, GarblingScheme scheme) {
+  uint64_t rows = 0;
+
+  for (size_t i = 0; i < gc->q; i++) {
+    if (scheme == GARBLING_SCHEME_HALF_GATES) {
+      rows += gc->gates[i].type == GARBLE_GATE_AND || gc->gates[i].type == GARBLE_GATE_OR;
+    } else {
+      rows += gc->gates[i].type != GARBLE_GATE_XOR;
+    }
+  }
+
+  if (scheme == GARBLING_SCHEME_HALF_GATES) {
+    return 2 * rows;
+  }
+
+  garble_circuit typed = *gc;
+  typed.type = libgarbleType(scheme);
+  return rows * garble_table_size(&typed) / sizeof(block);
+}
+
 // A Struct to store the cryptographic information for a garbled circuit, in compact form.
 struct GarbledInfo {
+  int version = GARBLED_INFO_VERSION_LIBGARBLE;
+  int garbleType = GARBLE_TYPE_HALFGATES; // for libgarble tables
   std::vector<bool> output_perms;
   std::vector<block> table;
   block fixed_label;
@@ -27,8 +92,65 @@ struct GarbledInfo {
 
   template <typename Packer> inline void msgpack_pack(Packer& pk) const;
 
+  // Gives the compact encoding up to the table, for a table of tableSize blocks, so the table can be written
+  // separately.
+  std::vector<char> compactPrefix(uint64_t tableSize) const {
+    uint32_t header[4] = {GARBLED_INFO_VERSION_COMPACT, (uint32_t) output_perms.size(), 0, 0};
+    std::memcpy(&header[2], &tableSize, sizeof(tableSize));
+
+    std::vector<char> prefix(GARBLED_INFO_COMPACT_HEADER_SIZE + 2 * sizeof(block) +
+                             (output_perms.size() + 127) / 128 * sizeof(block), 0);
+    std::memcpy(prefix.data(), header, sizeof(header));
+    std::memcpy(prefix.data() + sizeof(header), &fixed_label, sizeof(block));
+    std::memcpy(prefix.data() + sizeof(header) + sizeof(block), &global_key, sizeof(block));
+
+    char *perms = prefix.data() + sizeof(header) + 2 * sizeof(block);
+    for (size_t i = 0; i < output_perms.size(); i++) {
+      perms[i / 8] |= output_perms[i] << (i % 8);
+    }
+
+    return prefix;
+  }
+
+  // Gives the size of the compact encoding up to the table, from its header.
+  static size_t compactPrefixSize(const char *header) {
+    uint32_t m;
+    std::memcpy(&m, header + sizeof(uint32_t), sizeof(m));
+
+    return GARBLED_INFO_COMPACT_HEADER_SIZE + 2 * sizeof(block) + (m + 127) / 128 * sizeof(block);
+  }
+
+  // Reads the compact encoding up to the table, setting everything but the table, and gives the number of table
+  // blocks that follow, so the table can be read separately.
+  uint64_t unpackCompactPrefix(const char *p) {
+    uint32_t header[2];
+    uint64_t tableSize;
+
+    std::memcpy(header, p, sizeof(header));
+    std::memcpy(&tableSize, p + sizeof(header), sizeof(tableSize));
+    if (header[0] != GARBLED_INFO_VERSION_COMPACT) { throw msgpack::type_error(); }
+
+    version = header[0];
+    p += GARBLED_INFO_COMPACT_HEADER_SIZE;
+    std::memcpy(&fixed_label, p, sizeof(block));
+    std::memcpy(&global_key, p + sizeof(block), sizeof(block));
+    p += 2 * sizeof(block);
+
+    output_perms.resize(header[1]);
+    for (size_t i = 0; i < output_perms.size(); i++) {
+      output_perms[i] = (p[i / 8] >> (i % 8)) & 1;
+    }
+
+    return tableSize;
+  }
+
   inline void msgpack_unpack(msgpack::object const& o);
 
+  // Gives whether the table is from libgarble, rather than halfGatesGarble.
+  bool libgarbleTable() const {
+    return version == GARBLED_INFO_VERSION_LIBGARBLE || version == GARBLED_INFO_VERSION_LIBGARBLE_TYPED;
+  }
+
   // This removes table entries for free (XOR) gates.
   void packTable(garble_circuit *gc) {
     table.resize(numNonXOR(gc) * garble_table_size(gc) / sizeof(block));
@@ -43,8 +165,25 @@ struct GarbledInfo {
     }
   };
 
+  // This attaches a libgarble table to a copy of the topology it was garbled from, which is the legacy topology for
+  // version 0, so it can be evaluated with garble_eval. The caller frees gc->output_perms and gc->table.
+  void attachLibgarbleTable(garble_circuit *gc) const {
+    gc->type = (garble_type_e) garbleType;
+    checkLibgarbleTable(gc);
+
+    gc->output_perms = (bool *) calloc(gc->m, sizeof(bool));
+    for (size_t i = 0; i < gc->m; i++) {
+      gc->output_perms[i] = output_perms[i];
+    }
+
+    unpackTable(gc);
+    gc->fixed_label = fixed_label;
+    gc->global_key = global_key;
+  };
+
   // This fills in a table with the garbled values for non-free (non-XOR) gates.
-  void unpackTable(garble_circuit *gc) {
+  void unpackTable(garble_circuit *gc) const {
+    checkLibgarbleTable(gc);
     gc->table = (block *) calloc(gc->q, garble_table_size(gc));
 
     const char *p = (const char *) table.data();
@@ -56,12 +195,35 @@ struct GarbledInfo {
       }
     }
   };
+
+  // Throws unless the table and output permutation bits fit the circuit, as they come from untrusted files.
+  void checkLibgarbleTable(garble_circuit *gc) const {
+    if (output_perms.size() != gc->m || table.size() * sizeof(block) != numNonXOR(gc) * garble_table_size(gc)) {
+      throw msgpack::type_error();
+    }
+  };
 };
 
 // Packs the GarbledInfo data structure.
 template <typename Packer>
 void GarbledInfo::msgpack_pack(Packer& pk) const {
-  pk.pack_array(2);
+  if (version == GARBLED_INFO_VERSION_COMPACT) {
+    std::vector<char> prefix = compactPrefix(table.size());
+
+    pk.pack_bin(prefix.size() + table.size() * sizeof(block));
+    pk.pack_bin_body(prefix.data(), prefix.size());
+    pk.pack_bin_body((const char *) table.data(), table.size() * sizeof(block));
+    return;
+  }
+
+  // libgarble tables keep the original two element layout, so they are still read by older code.
+  if (version == GARBLED_INFO_VERSION_LIBGARBLE) {
+    pk.pack_array(2);
+  } else if (version == GARBLED_INFO_VERSION_LIBGARBLE_TYPED) {
+    pk.pack_array(4);
+  } else {
+    pk.pack_array(3);
+  }
 
   pk.pack_array(output_perms.size());
   for (size_t i = 0; i < output_perms.size(); i++) {
@@ -76,12 +238,51 @@ void GarbledInfo::msgpack_pack(Packer& pk) const {
   pk.pack_bin_body((const char *) table.data(), table.size() * sizeof(block));
   pk.pack_bin_body((const char *) &fixed_label, sizeof(block));
   pk.pack_bin_body((const char *) &global_key, sizeof(block));
+
+  if (version != GARBLED_INFO_VERSION_LIBGARBLE) {
+    pk.pack(version);
+  }
+  if (version == GARBLED_INFO_VERSION_LIBGARBLE_TYPED) {
+    pk.pack(garbleType);
+  }
 };
 
 // Unpacks the GarbledInfo data structure.
 void GarbledInfo::msgpack_unpack(msgpack::object const& o) {
+  if (o.type == msgpack::type::BIN) {
+    if (o.via.bin.size < GARBLED_INFO_COMPACT_HEADER_SIZE ||
+        o.via.bin.size < compactPrefixSize(o.via.bin.ptr)) {
+      throw msgpack::type_error();
+    }
+
+    uint64_t tableSize = unpackCompactPrefix(o.via.bin.ptr);
+    if (o.via.bin.size != compactPrefixSize(o.via.bin.ptr) + tableSize * sizeof(block)) {
+      throw msgpack::type_error();
+    }
+
+    table.resize(tableSize);
+    std::memcpy(table.data(), o.via.bin.ptr + compactPrefixSize(o.via.bin.ptr), tableSize * sizeof(block));
+    return;
+  }
+
   if (o.type != msgpack::type::ARRAY) { throw msgpack::type_error(); }
-  assert(o.via.array.size == 2);
+  assert(o.via.array.size >= 2 && o.via.array.size <= 4);
+
+  if (o.via.array.size >= 3) {
+    version = o.via.array.ptr[2].as<int>();
+  } else {
+    version = GARBLED_INFO_VERSION_LIBGARBLE;
+  }
+  if (o.via.array.size == 4) {
+    garbleType = o.via.array.ptr[3].as<int>();
+
+    // The type sets the size of the table rows, so only the types SS garbles with are read.
+    if (garbleType != GARBLE_TYPE_STANDARD && garbleType != GARBLE_TYPE_HALFGATES) {
+      throw msgpack::type_error();
+    }
+  } else {
+    garbleType = GARBLE_TYPE_HALFGATES;
+  }
 
   output_perms.resize(o.via.array.ptr[0].via.array.size);
   for (size_t i = 0; i < output_perms.size(); i++) {
@@ -0,0 +1,106 @@
+#ifndef HALF_GATES_H
+#define HALF_GATES_H
+
+#include <vector>
+#include <istream>
+#include <ostream>
+#include <cstdint>
+
+#include "libgarble/garble.h"
+#include "libgarble/garbled_info.h"
+#include "circuit/wire_slots.h"
+
+/* Half-gates garbling, as in Zahur, Rosulek and Evans, "Two Halves Make a Whole", over the gates of a circuit built
+ * with libgarble's circuit builder. Unlike garble_garble, this never holds a table with a row for every gate: rows
+ * are only made for AND and OR gates, and are written in gate order straight into the compact table of a
+ * GarbledInfo. XOR and NOT gates are free, and the constant wires get their labels from fixed_label.
+ */
+
+// Blocks in the table row of each AND or OR gate.
+#define HALF_GATES_ROW_BLOCKS 2
+
+// Rows read at a time by StreamRowSource, and written at a time by halfGatesGarble to a GarbledRowSink.
+#define HALF_GATES_CHUNK_ROWS 65536
+
+// Number of gates given a row of the table.
+size_t halfGatesRows(const garble_circuit *topology);
+
+// Garbles the circuit with the gates of topology, which is only read, so the cached universal circuit can be shared.
+// inputLabels is set to both labels of each input wire, with the label for bit b of input i at 2 * i + b, and info to
+// the table, output permutation bits and keys.
+void halfGatesGarble(const garble_circuit *topology, std::vector<block> &inputLabels, GarbledInfo &info);
+
+// Takes the rows of a garbled table from halfGatesGarble, in gate order.
+class GarbledRowSink {
+ public:
+  virtual ~GarbledRowSink() {};
+
+  // Takes the next count rows, which are only valid during the call.
+  virtual void writeRows(const block *rows, size_t count) = 0;
+};
+
+// Writes the rows of a table to a stream as they are garbled.
+class StreamRowSink : public GarbledRowSink {
+ public:
+  StreamRowSink(std::ostream &out): out(out) {};
+
+  virtual void writeRows(const block *rows, size_t count);
+
+ private:
+  std::ostream &out;
+};
+
+// Appends the rows of a table to a table held in memory.
+class TableRowSink : public GarbledRowSink {
+ public:
+  TableRowSink(std::vector<block> &table): table(table) {};
+
+  virtual void writeRows(const block *rows, size_t count);
+
+ private:
+  std::vector<block> &table;
+};
+
+// As above, but keeps labels in the given wire slots and gives the table rows to rows, a chunk at a time, rather than
+// setting info.table, so memory does not grow with the number of gates.
+void halfGatesGarble(const garble_circuit *topology, const WireSlots &wireSlots, std::vector<block> &inputLabels,
+                     GarbledInfo &info, GarbledRowSink &rows);
+
+// Evaluates a circuit garbled by halfGatesGarble, given one label per input wire, reading the table rows in gate
+// order, and sets the m output bits. Labels are kept in the given wire slots, so no memory is allocated in
+// proportion to the number of gates.
+void halfGatesEval(const garble_circuit *topology, const WireSlots &wireSlots, const block *inputLabels,
+                   const GarbledInfo &info, bool *outputs);
+
+// Gives the rows of a garbled table to halfGatesEval, in gate order.
+class GarbledRowSource {
+ public:
+  virtual ~GarbledRowSource() {};
+
+  // Gives at least one of the next rows, and sets count to the number given. They stay valid until the next call.
+  // Throws if the table has ended.
+  virtual const block *nextRows(size_t &count) = 0;
+};
+
+// Reads the rows of a table from a stream, one chunk at a time, so only a chunk of the table is held in memory.
+class StreamRowSource : public GarbledRowSource {
+ public:
+  // The table, of the given number of rows, starts at the current position of in.
+  StreamRowSource(std::istream &in, uint64_t rows, size_t chunkRows = HALF_GATES_CHUNK_ROWS);
+
+  virtual const block *nextRows(size_t &count);
+
+ private:
+  std::istream &in;
+  uint64_t rowsLeft;
+  std::vector<block> buffer;
+};
+
+// As above, but reads the table rows from rows, ignoring info.table.
+void halfGatesEval(const garble_circuit *topology, const WireSlots &wireSlots, const block *inputLabels,
+                   const GarbledInfo &info, GarbledRowSource &rows, bool *outputs);
+
+// As above, assigning the wire slots first.
+void halfGatesEval(const garble_circuit *topology, const block *inputLabels, const GarbledInfo &info, bool *outputs);
+
+#endif
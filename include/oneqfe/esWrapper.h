@@ -32,6 +32,18 @@ public:
     return KeyPair(ES::Setup(length));
   };
 
+  static KeyPair Derive(const std::vector<unsigned char> &seed, int length, uint64_t index) {
+    return KeyPair(ES::Derive(seed, length, index));
+  };
+
+  static void DeriveBatch(const std::vector<unsigned char> &seed, int length, const uint64_t *indices, size_t n,
+                          std::vector<KeyPair> &pairs) {
+    std::vector<typename ES::KeyPair> derived;
+    ES::DeriveBatch(seed, length, indices, n, derived);
+
+    pairs.insert(pairs.end(), derived.begin(), derived.end());
+  };
+
   static SecretKey KeyGen(MasterSecretKey msk) {
     return msk;
   };
@@ -40,12 +52,21 @@ public:
     return ES::Encrypt(mpk, msg);
   };
 
-  static PlainText Decrypt(SecretKey sk, CipherText ct) {
+  static void EncryptBatch(const MasterPublicKey *const *mpks, const PlainText *msgs, CipherText *cts, size_t n) {
+    ES::EncryptBatch(mpks, msgs, cts, n);
+  };
+
+  static PlainText Decrypt(const SecretKey &sk, const CipherText &ct) {
     return ES::Decrypt(sk, ct);
   };
+
+  static void DecryptBatch(const SecretKey *const *sks, const CipherText *const *cts, PlainText *pts, size_t n) {
+    ES::DecryptBatch(sks, cts, pts, n);
+  };
 };
 
 typedef ESWrapper<AES> AESWrapper;
 typedef ESWrapper<RSA> RSAWrapper;
+typedef ESWrapper<ECC> ECCWrapper;
 
 #endif
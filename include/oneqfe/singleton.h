@@ -2,8 +2,11 @@
 #define SINGLETON
 
 #include <string>
+#include <vector>
 #include <msgpack.hpp>
 
+#include "util/random.h"
+
 /* This class template turns an existing functional encryption scheme into
  * one using noncommitting encryption, to aid in achieving adaptive security.
  */
@@ -56,10 +59,46 @@ public:
     return p;
   };
 
+  // Derives both key pairs from the seed, as the pairs numbered 2 * index and 2 * index + 1 in ES.
+  static KeyPair Derive(const std::vector<unsigned char> &seed, int length, uint64_t index) {
+    KeyPair p;
+    typename ES::KeyPair p1 = ES::Derive(seed, length, 2 * index);
+    typename ES::KeyPair p2 = ES::Derive(seed, length, 2 * index + 1);
+
+    p.sk.sks.first = p1.sk;
+    p.sk.sks.second = p2.sk;
+    p.pk.pks.first = p1.pk;
+    p.pk.pks.second = p2.pk;
+
+    return p;
+  };
+
+  // As Derive, for the pairs numbered indices[i], deriving all of their ES key pairs in one batch.
+  static void DeriveBatch(const std::vector<unsigned char> &seed, int length, const uint64_t *indices, size_t n,
+                          std::vector<KeyPair> &pairs) {
+    std::vector<uint64_t> esIndices(2 * n);
+    for (size_t i = 0; i < n; i++) {
+      esIndices[2 * i] = 2 * indices[i];
+      esIndices[2 * i + 1] = 2 * indices[i] + 1;
+    }
+
+    std::vector<typename ES::KeyPair> derived;
+    ES::DeriveBatch(seed, length, esIndices.data(), esIndices.size(), derived);
+
+    pairs.resize(pairs.size() + n);
+    for (size_t i = 0; i < n; i++) {
+      KeyPair &p = pairs[pairs.size() - n + i];
+      p.sk.sks.first = derived[2 * i].sk;
+      p.sk.sks.second = derived[2 * i + 1].sk;
+      p.pk.pks.first = derived[2 * i].pk;
+      p.pk.pks.second = derived[2 * i + 1].pk;
+    }
+  };
+
   static SecretKey KeyGen(MasterSecretKey msk) {
     SecretKey sk;
 
-    int bit = rand() % 2;
+    int bit = threadRandom().uniform(2);
     sk.bit = bit;
     if (bit == 0) {
       sk.sk = msk.sks.first;
@@ -79,16 +118,51 @@ public:
     return ct;
   };
 
-  static PlainText Decrypt(SecretKey sk, CipherText ct) {
+  // Encrypts msgs[i] under *mpks[i] into cts[i], for i < n, using a single batch of 2n encryptions in ES.
+  static void EncryptBatch(const MasterPublicKey *const *mpks, const PlainText *msgs, CipherText *cts, size_t n) {
+    std::vector<const typename ES::PublicKey *> pks(2 * n);
+    std::vector<PlainText> pts(2 * n);
+    std::vector<typename ES::CipherText> esCts(2 * n);
+
+    for (size_t i = 0; i < n; i++) {
+      pks[2 * i] = &mpks[i]->pks.first;
+      pks[2 * i + 1] = &mpks[i]->pks.second;
+      pts[2 * i] = msgs[i];
+      pts[2 * i + 1] = msgs[i];
+    }
+
+    ES::EncryptBatch(pks.data(), pts.data(), esCts.data(), 2 * n);
+
+    for (size_t i = 0; i < n; i++) {
+      cts[i].cts.first = esCts[2 * i];
+      cts[i].cts.second = esCts[2 * i + 1];
+    }
+  };
+
+  static PlainText Decrypt(const SecretKey &sk, const CipherText &ct) {
     if (sk.bit == 0) {
       return ES::Decrypt(sk.sk, ct.cts.first);
     } else {
       return ES::Decrypt(sk.sk, ct.cts.second);
     }
   };
+
+  // Decrypts *cts[i] under *sks[i] into pts[i], for i < n, using a single batch of n decryptions in ES.
+  static void DecryptBatch(const SecretKey *const *sks, const CipherText *const *cts, PlainText *pts, size_t n) {
+    std::vector<const typename ES::SecretKey *> esSks(n);
+    std::vector<const typename ES::CipherText *> esCts(n);
+
+    for (size_t i = 0; i < n; i++) {
+      esSks[i] = &sks[i]->sk;
+      esCts[i] = sks[i]->bit == 0 ? &cts[i]->cts.first : &cts[i]->cts.second;
+    }
+
+    ES::DecryptBatch(esSks.data(), esCts.data(), pts, n);
+  };
 };
 
 typedef Singleton<AES> SingletonAES;
 typedef Singleton<RSA> SingletonRSA;
+typedef Singleton<ECC> SingletonECC;
 
 #endif
@@ -4,12 +4,14 @@
 #include <vector>
 #include <string>
 #include <iostream>
+#include <memory>
 #include <msgpack.hpp>
 
 #include "circuit/circuit.h"
 #include "pke/pke.h"
 #include "oneqfe/esWrapper.h"
 #include "oneqfe/singleton.h"
+#include "util/pool.h"
 
 #include "libgarble/garble.h"
 #include "libgarble/garbled_info.h"
@@ -18,30 +20,42 @@
  * Sehai-Seyalioglu functional encryption scheme.
  */
 
+// Cipher texts whose input labels are decrypted together by DecryptBatch, on each thread.
+#define SS_DECRYPT_BATCH_GROUP 16
+
 template <class ES>
 class SS {
 private:
   CircuitDescription *circuitDescription;
+  int threads;
+  GarblingScheme scheme;
+  bool seededKeys;
 
 public:
+  // Seeded master keys leave sks empty, and derive the keys for label b of circuit input i with ES::Derive, as the
+  // pair numbered 2 * i + b.
   struct MasterSecretKey {
-    //size circuit_size
+    //size circuit_size, or 0 when seeded
     std::vector<std::pair<typename ES::MasterSecretKey, typename ES::MasterSecretKey> > sks;
+    std::vector<unsigned char> seed; // empty unless seeded
+    int keyLength = 0;
 
     MasterSecretKey() {};
     MasterSecretKey(int size): sks(size) {};
 
-    MSGPACK_DEFINE(sks);
+    MSGPACK_DEFINE(sks, seed, keyLength);
   };
 
   struct MasterPublicKey {
-    //size circuit_size
+    //size circuit_size, or 0 when seeded
     std::vector<std::pair<typename ES::MasterPublicKey, typename ES::MasterPublicKey> > pks;
+    std::vector<unsigned char> seed; // empty unless seeded, as public keys are secret keys for SKEs
+    int keyLength = 0;
 
     MasterPublicKey() {};
     MasterPublicKey(int size): pks(size) {};
 
-    MSGPACK_DEFINE(pks);
+    MSGPACK_DEFINE(pks, seed, keyLength);
   };
 
   struct KeyPair {
@@ -49,11 +63,25 @@ public:
     MasterPublicKey pk;
   };
 
+  // Packed as the bits, 8 to a byte, then the keys. Keys packed with a msgpack array of ints for the bits are still
+  // read.
   struct SecretKey {
     std::vector<int> bits; // size circuit_size
     std::vector<typename ES::SecretKey> sks; // size circuit_size
 
-    MSGPACK_DEFINE(bits, sks);
+    template <typename Packer> inline void msgpack_pack(Packer& pk) const;
+
+    inline void msgpack_unpack(msgpack::object const& o);
+
+    // Pack and unpack the bits and keys apart, so keys for the same circuit can share the bits. The bits are unpacked
+    // after the keys, as there is a bit for each key.
+    template <typename Packer> inline void packBits(Packer& pk) const;
+
+    template <typename Packer> inline void packKeys(Packer& pk) const;
+
+    inline void unpackBits(msgpack::object const& o);
+
+    inline void unpackKeys(msgpack::object const& o);
   };
 
   struct CipherText {
@@ -63,10 +91,18 @@ public:
  
     template <typename Packer> inline void msgpack_pack(Packer& pk) const;
 
+    // Packs what follows garbled_info, which is everything but the garbled circuit.
+    template <typename Packer> inline void packLabelsAndInputs(Packer& pk) const;
+
     inline void msgpack_unpack(msgpack::object const& o);
   };
 
-  SS(CircuitDescription *description);
+  // threads is the number of worker threads used to encrypt and decrypt the circuit input labels, and scheme is how
+  // Encrypt garbles the circuit. Decrypt reads cipher texts from any scheme. With seededKeys, Setup gives master keys
+  // holding a single random seed, in constant time, rather than a key pair for every circuit input label. This is
+  // only supported when ES is built on an SKE, such as AES. KeyGen and Encrypt take master keys of either kind.
+  SS(CircuitDescription *description, int threads = 1, GarblingScheme scheme = GARBLING_SCHEME_HALF_GATES,
+     bool seededKeys = false);
 
   KeyPair Setup(int length);
 
@@ -74,7 +110,144 @@ public:
 
   CipherText Encrypt(MasterPublicKey mpk, std::vector<int> msg);
 
-  std::vector<int> Decrypt(SecretKey sk, CipherText ct);
+  // Encrypts msg, writing the cipher text to out as writeToFile would, so it can be read back with readFromFile or
+  // DecryptFromFile. The garbled table is written in gate order as it is garbled, and never held in memory. out must be
+  // seekable, as the output permutation bits, which come before the table, are written once garbling ends. Schemes
+  // other than GARBLING_SCHEME_HALF_GATES garble the whole circuit in memory first.
+  void Encrypt(MasterPublicKey mpk, std::vector<int> msg, std::ostream &out);
+
+  // Starts refillThreads background threads keeping up to depth circuits garbled ahead of time, with their inputs
+  // encrypted under mpk, for Encrypt(msg). depth must be positive. Replaces this scheme's pool, if it has one.
+  // Copies of this scheme made afterwards share the pool.
+  void StartGarblingPool(MasterPublicKey mpk, size_t depth, int refillThreads = 1);
+
+  // Drops this scheme's share of the garbling pool. Its threads stop, and the circuits garbled ahead of time are
+  // dropped, once no copy of this scheme shares it.
+  void StopGarblingPool();
+
+  // Gives the number of circuits garbled ahead of time and ready in the pool, counting those that failed to garble,
+  // for which Encrypt(msg) throws.
+  size_t GarblingPoolReady();
+
+  // Encrypts msg under the key given to StartGarblingPool, taking a circuit garbled ahead of time from the pool, or
+  // waiting for one, so only the labels for the message are picked. Each garbled circuit is only used once. Throws
+  // what garbling the circuit threw, if it failed.
+  CipherText Encrypt(std::vector<int> msg);
+
+  // Throws msgpack::type_error if ct does not have a label for every circuit input, and std::runtime_error if sk does
+  // not have a key for every encrypted label of ct.
+  std::vector<int> Decrypt(const SecretKey &sk, const CipherText &ct);
+
+  // Decrypts a cipher text written to fileName with writeToFile, without reading it whole. Only the labels and
+  // encrypted inputs are held in memory, and the garbled table is read from the file in chunks, in gate order, while
+  // the circuit is evaluated. Cipher texts not in the compact encoding are read whole and passed to Decrypt. Throws
+  // if the file can not be opened, and as Decrypt does if it is cut short or does not fit the circuit or sk.
+  std::vector<int> DecryptFromFile(const SecretKey &sk, std::string fileName);
+
+  // Decrypts many cipher texts under one key, giving the outputs of Decrypt for each, spread across the threads. The
+  // input labels of groups of cipher texts are decrypted in one batch, ordered by key, and buffers are reused. Every
+  // cipher text is checked as in Decrypt before any is decrypted.
+  std::vector<std::vector<int> > DecryptBatch(const SecretKey &sk, const std::vector<CipherText> &cts);
+
+  // Decrypts one cipher text under many keys, giving the outputs of Decrypt for each, spread across the threads. The
+  // garbled circuit is prepared once and only read, so each key only decrypts its labels and evaluates the circuit.
+  std::vector<std::vector<int> > DecryptMany(const std::vector<SecretKey> &sks, const CipherText &ct);
+
+private:
+  // A circuit garbled ahead of time, with every part of its cipher text but the labels for the message.
+  struct Garbling {
+    CipherText ct;
+    std::vector<block> messageLabels; // both labels of each message input, as from halfGatesGarble
+  };
+
+  std::shared_ptr<RefillPool<Garbling> > garblingPool;
+
+  // Garbles the circuit into ct, setting inputLabels to both labels of every input, and encrypts the labels of
+  // every circuit input under mpk.
+  void garble(const MasterPublicKey &mpk, std::vector<block> &inputLabels, CipherText &ct);
+
+  // Garbles the circuit into info with libgarble, for schemes other than GARBLING_SCHEME_HALF_GATES.
+  void garbleWithLibgarble(std::vector<block> &inputLabels, GarbledInfo &info);
+
+  // Encrypts both labels of every circuit input into ct, given the labels from garbling.
+  void encryptInputs(const MasterPublicKey &mpk, const std::vector<block> &inputLabels, CipherText &ct);
+
+  // Sets the labels of ct for msg, given the labels from garbling.
+  void setMessageLabels(std::vector<int> &msg, const std::vector<block> &inputLabels, CipherText &ct);
+
+  // Gives the topology the table of info was garbled over, which is the legacy universal circuit for version 0.
+  const garble_circuit *topologyOf(const GarbledInfo &info);
+
+  // Evaluates the garbled circuit of ct into vals, given the labels of every circuit input, on the calling thread.
+  void evaluate(const CipherText &ct, const block *labels, bool *vals);
+
+  // Decrypts the labels given by sk for circuit inputs [begin, end) of *cts[j], for j < count, into the labels of
+  // every circuit input for cts[j], which start at labels + j * n, as one batch in ES with the cipher texts of each
+  // input together.
+  void decryptLabels(const SecretKey &sk, const CipherText *const *cts, size_t count, size_t begin, size_t end,
+                     block *labels);
+};
+
+template<class ES> template <typename Packer>
+void SS<ES>::SecretKey::msgpack_pack(Packer& pk) const {
+  pk.pack_array(2);
+
+  packBits(pk);
+  packKeys(pk);
+};
+
+template<class ES> template <typename Packer>
+void SS<ES>::SecretKey::packBits(Packer& pk) const {
+  std::vector<unsigned char> packed((bits.size() + 7) / 8);
+  for (size_t i = 0; i < bits.size(); i++) {
+    packed[i / 8] |= (bits[i] != 0) << (i % 8);
+  }
+
+  pk.pack_bin(packed.size());
+  pk.pack_bin_body((const char *) packed.data(), packed.size());
+};
+
+template<class ES> template <typename Packer>
+void SS<ES>::SecretKey::packKeys(Packer& pk) const {
+  pk.pack_array(sks.size());
+  for (size_t i = 0; i < sks.size(); i++) {
+    sks[i].msgpack_pack(pk);
+  }
+};
+
+template<class ES>
+void SS<ES>::SecretKey::msgpack_unpack(msgpack::object const& o) {
+  if (o.type != msgpack::type::ARRAY || o.via.array.size != 2) { throw msgpack::type_error(); }
+
+  unpackKeys(o.via.array.ptr[1]);
+  unpackBits(o.via.array.ptr[0]);
+};
+
+template<class ES>
+void SS<ES>::SecretKey::unpackBits(msgpack::object const& o) {
+  if (o.type == msgpack::type::ARRAY) {
+    o.convert(bits);
+  } else if (o.type == msgpack::type::BIN && o.via.bin.size == (sks.size() + 7) / 8) {
+    const unsigned char *packed = (const unsigned char *) o.via.bin.ptr;
+    bits.resize(sks.size());
+    for (size_t i = 0; i < bits.size(); i++) {
+      bits[i] = (packed[i / 8] >> (i % 8)) & 1;
+    }
+  } else {
+    throw msgpack::type_error();
+  }
+
+  if (bits.size() != sks.size()) { throw msgpack::type_error(); }
+};
+
+template<class ES>
+void SS<ES>::SecretKey::unpackKeys(msgpack::object const& o) {
+  if (o.type != msgpack::type::ARRAY) { throw msgpack::type_error(); }
+
+  sks.resize(o.via.array.size);
+  for (size_t i = 0; i < sks.size(); i++) {
+    sks[i].msgpack_unpack(o.via.array.ptr[i]);
+  }
 };
 
 template<class ES> template <typename Packer>
@@ -82,7 +255,11 @@ void SS<ES>::CipherText::msgpack_pack(Packer& pk) const {
   pk.pack_array(3);
 
   garbled_info.msgpack_pack(pk);
+  packLabelsAndInputs(pk);
+};
 
+template<class ES> template <typename Packer>
+void SS<ES>::CipherText::packLabelsAndInputs(Packer& pk) const {
   pk.pack_bin(labels.size() * sizeof(block));
   pk.pack_bin_body((const char *) labels.data(), labels.size() * sizeof(block));
 
@@ -115,5 +292,7 @@ typedef SS<AESWrapper> SS_AES;
 typedef SS<RSAWrapper> SS_RSA;
 typedef SS<SingletonAES> SS_SingletonAES;
 typedef SS<SingletonRSA> SS_SingletonRSA;
+typedef SS<ECCWrapper> SS_ECC;
+typedef SS<SingletonECC> SS_SingletonECC;
 
 #endif
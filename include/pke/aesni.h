@@ -0,0 +1,88 @@
+#ifndef AESNI_H
+#define AESNI_H
+
+#include <cstddef>
+#include <algorithm>
+
+#include <wmmintrin.h>
+#include <emmintrin.h>
+
+/* AES-128 encryption with AES-NI instructions, for encrypting many single
+ * blocks under many keys at once. Blocks are processed in groups of
+ * AESNI_PIPELINE, so that the rounds of independent blocks are interleaved.
+ */
+
+#define AESNI_ROUNDS 10
+
+#define AESNI_PIPELINE 8
+
+// One step of the AES-128 key schedule.
+inline __m128i aesKeyExpandStep(__m128i key, __m128i assist) {
+  assist = _mm_shuffle_epi32(assist, _MM_SHUFFLE(3, 3, 3, 3));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  return _mm_xor_si128(key, assist);
+}
+
+// Expands a 16 byte key into the AESNI_ROUNDS + 1 round keys of AES-128.
+inline void aesExpandKey128(const unsigned char *key, __m128i *roundKeys) {
+  roundKeys[0] = _mm_loadu_si128((const __m128i *) key);
+  roundKeys[1] = aesKeyExpandStep(roundKeys[0], _mm_aeskeygenassist_si128(roundKeys[0], 0x01));
+  roundKeys[2] = aesKeyExpandStep(roundKeys[1], _mm_aeskeygenassist_si128(roundKeys[1], 0x02));
+  roundKeys[3] = aesKeyExpandStep(roundKeys[2], _mm_aeskeygenassist_si128(roundKeys[2], 0x04));
+  roundKeys[4] = aesKeyExpandStep(roundKeys[3], _mm_aeskeygenassist_si128(roundKeys[3], 0x08));
+  roundKeys[5] = aesKeyExpandStep(roundKeys[4], _mm_aeskeygenassist_si128(roundKeys[4], 0x10));
+  roundKeys[6] = aesKeyExpandStep(roundKeys[5], _mm_aeskeygenassist_si128(roundKeys[5], 0x20));
+  roundKeys[7] = aesKeyExpandStep(roundKeys[6], _mm_aeskeygenassist_si128(roundKeys[6], 0x40));
+  roundKeys[8] = aesKeyExpandStep(roundKeys[7], _mm_aeskeygenassist_si128(roundKeys[7], 0x80));
+  roundKeys[9] = aesKeyExpandStep(roundKeys[8], _mm_aeskeygenassist_si128(roundKeys[8], 0x1b));
+  roundKeys[10] = aesKeyExpandStep(roundKeys[9], _mm_aeskeygenassist_si128(roundKeys[9], 0x36));
+}
+
+// Encrypts blocks[i] in place under the round keys starting at roundKeys[i * (AESNI_ROUNDS + 1)], for i < n.
+inline void aesEncryptBlocks(const __m128i *roundKeys, __m128i *blocks, size_t n) {
+  for (size_t i = 0; i < n; i += AESNI_PIPELINE) {
+    size_t count = std::min((size_t) AESNI_PIPELINE, n - i);
+    const __m128i *keys = roundKeys + i * (AESNI_ROUNDS + 1);
+    __m128i *b = blocks + i;
+
+    for (size_t j = 0; j < count; j++) {
+      b[j] = _mm_xor_si128(b[j], keys[j * (AESNI_ROUNDS + 1)]);
+    }
+
+    for (int r = 1; r < AESNI_ROUNDS; r++) {
+      for (size_t j = 0; j < count; j++) {
+        b[j] = _mm_aesenc_si128(b[j], keys[j * (AESNI_ROUNDS + 1) + r]);
+      }
+    }
+
+    for (size_t j = 0; j < count; j++) {
+      b[j] = _mm_aesenclast_si128(b[j], keys[j * (AESNI_ROUNDS + 1) + AESNI_ROUNDS]);
+    }
+  }
+}
+
+// Encrypts blocks[i] in place under the single key with the given round keys, for i < n.
+inline void aesEncryptBlocksFixedKey(const __m128i *roundKeys, __m128i *blocks, size_t n) {
+  for (size_t i = 0; i < n; i += AESNI_PIPELINE) {
+    size_t count = std::min((size_t) AESNI_PIPELINE, n - i);
+    __m128i *b = blocks + i;
+
+    for (size_t j = 0; j < count; j++) {
+      b[j] = _mm_xor_si128(b[j], roundKeys[0]);
+    }
+
+    for (int r = 1; r < AESNI_ROUNDS; r++) {
+      for (size_t j = 0; j < count; j++) {
+        b[j] = _mm_aesenc_si128(b[j], roundKeys[r]);
+      }
+    }
+
+    for (size_t j = 0; j < count; j++) {
+      b[j] = _mm_aesenclast_si128(b[j], roundKeys[AESNI_ROUNDS]);
+    }
+  }
+}
+
+#endif
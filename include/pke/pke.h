@@ -2,6 +2,8 @@
 #define PKE_H
 
 #include <string>
+#include <vector>
+#include <cstdint>
 
 #include "types.h"
 #include "file/writable.h"
@@ -32,17 +34,35 @@ public:
 
   static KeyPair Setup(int length);
 
+  // Derives the key pair numbered index, of the given length, from a 16 byte seed, with a PRF, so many keys can be
+  // kept as one seed. Only supported by SKEs.
+  static KeyPair Derive(const std::vector<unsigned char> &seed, int length, uint64_t index);
+
+  // Appends the key pairs numbered indices[i], for i < n, to pairs, as from Derive, preparing the seed only once.
+  static void DeriveBatch(const std::vector<unsigned char> &seed, int length, const uint64_t *indices, size_t n,
+                          std::vector<KeyPair> &pairs);
+
   static CipherText Encrypt(PublicKey pk, PlainText msg);
 
-  static PlainText Decrypt(SecretKey sk, CipherText ct);
+  // Encrypts msgs[i] under *pks[i] into cts[i], for i < n. The cipher texts are the same as from Encrypt.
+  static void EncryptBatch(const PublicKey *const *pks, const PlainText *msgs, CipherText *cts, size_t n);
+
+  static PlainText Decrypt(const SecretKey &sk, const CipherText &ct);
+
+  // Decrypts *cts[i] under *sks[i] into pts[i], for i < n. Runs of cipher texts under the same key are fastest.
+  static void DecryptBatch(const SecretKey *const *sks, const CipherText *const *cts, PlainText *pts, size_t n);
 };
 
 template class PKEBase<AESTypes>;
 
 template class PKEBase<RSATypes>;
 
+template class PKEBase<ECCTypes>;
+
 typedef PKEBase<AESTypes> AES;
 
 typedef PKEBase<RSATypes> RSA;
 
+typedef PKEBase<ECCTypes> ECC;
+
 #endif
@@ -3,16 +3,23 @@
 
 #include <crypto++/rsa.h>
 #include <crypto++/aes.h>
+#include <crypto++/eccrypto.h>
+#include <crypto++/oids.h>
 #include <string>
+#include <memory>
 #include <msgpack.hpp>
 
 #include "file/writable.h"
+#include "pke/aesni.h"
 
 //Default size for AES keys (128 bits)
 #ifndef AES_DEFAULT_KEYLENGTH
 #define AES_DEFAULT_KEYLENGTH CryptoPP::AES::DEFAULT_KEYLENGTH
 #endif
 
+// Size in bits of the curve used for ECIES, NIST P-256
+#define ECC_KEYLENGTH 256
+
 /* This file defines the types used by public and secret key encryption schemes. * Also included are methods for reading and writing keys for these schemes.
  */
 
@@ -27,11 +34,16 @@ class RSATypes {
     inline void msgpack_unpack(msgpack::object const& o);
   };
 
+  // Keeps an encryptor for pk, made when the key is made or unpacked, and shared by its copies. Call prepare after
+  // changing pk.
   struct PublicKey {
     CryptoPP::RSA::PublicKey pk;
+    std::shared_ptr<const CryptoPP::RSAES_OAEP_SHA_Encryptor> encryptor;
 
     PublicKey() {};
-    PublicKey(SecretKey sk): pk(sk.sk) {};
+    PublicKey(SecretKey sk): pk(sk.sk) { prepare(); };
+
+    void prepare() { encryptor = std::make_shared<CryptoPP::RSAES_OAEP_SHA_Encryptor>(pk); };
 
     template <typename Packer> inline void msgpack_pack(Packer& pk) const;
 
@@ -51,11 +63,31 @@ class RSATypes {
 // Types for AES, a SKE scheme.
 class AESTypes {
 public:
+  // The round keys of an AES-128 key, wiped when dropped.
+  struct KeySchedule {
+    __m128i roundKeys[AESNI_ROUNDS + 1];
+
+    KeySchedule(const unsigned char *key) { aesExpandKey128(key, roundKeys); };
+    ~KeySchedule() {
+      volatile unsigned char *bytes = (volatile unsigned char *) roundKeys;
+      for (size_t i = 0; i < sizeof(roundKeys); i++) {
+        bytes[i] = 0;
+      }
+    };
+  };
+
+  // Keeps the round keys of a 16 byte key, made when the key is made or unpacked, and shared by its copies. Call
+  // prepare after changing key.
   struct Key {
     CryptoPP::SecByteBlock key;
+    std::shared_ptr<const KeySchedule> schedule; // empty for other key lengths
 
     Key() {};
-    Key(unsigned char *byte, int length): key(byte, length) {};
+    Key(unsigned char *byte, int length): key(byte, length) { prepare(); };
+
+    void prepare() {
+      schedule = key.size() == 16 ? std::make_shared<const KeySchedule>(key.data()) : nullptr;
+    };
 
     template <typename Packer> inline void msgpack_pack(Packer& pk) const;
 
@@ -77,6 +109,40 @@ public:
   };
 };
 
+// Types for ECIES over NIST P-256, a PKE scheme. Points are packed, and put in cipher texts, compressed.
+class ECCTypes {
+ public:
+  typedef CryptoPP::ECIES<CryptoPP::ECP> Scheme;
+
+  struct SecretKey {
+    Scheme::PrivateKey sk;
+
+    template <typename Packer> inline void msgpack_pack(Packer& pk) const;
+
+    inline void msgpack_unpack(msgpack::object const& o);
+  };
+
+  struct PublicKey {
+    Scheme::PublicKey pk;
+
+    PublicKey() {};
+    PublicKey(SecretKey sk) { sk.sk.MakePublicKey(pk); };
+
+    template <typename Packer> inline void msgpack_pack(Packer& pk) const;
+
+    inline void msgpack_unpack(msgpack::object const& o);
+  };
+
+  struct CipherText {
+    std::vector<unsigned char> ct;
+
+    CipherText() {};
+    CipherText(size_t size): ct(size) {};
+
+    MSGPACK_DEFINE(ct);
+  };
+};
+
 // Packing integers, used to pack RSA keys.
 template <typename Packer> inline void packInteger(Packer& pk, CryptoPP::Integer x) {
   std::vector<unsigned char> output(x.MinEncodedSize());
@@ -141,6 +207,7 @@ void RSATypes::PublicKey::msgpack_unpack(msgpack::object const& o) {
   n = unpackInteger(o.via.array.ptr[0]);
   e = unpackInteger(o.via.array.ptr[1]);
   this->pk.Initialize(n, e);
+  prepare();
 };
 
 // Packing AES Keys.
@@ -153,6 +220,40 @@ template <typename Packer> void AESTypes::Key::msgpack_pack(Packer& pk) const {
 void AESTypes::Key::msgpack_unpack(msgpack::object const& o) {
   if (o.type != msgpack::type::BIN) { throw msgpack::type_error(); }
   key = CryptoPP::SecByteBlock((unsigned char *) o.via.bin.ptr, o.via.bin.size);
+  prepare();
+};
+
+// Packing ECC Secret Keys, as the private exponent.
+template <typename Packer> void ECCTypes::SecretKey::msgpack_pack(Packer& pk) const {
+  packInteger(pk, sk.GetPrivateExponent());
+};
+
+// Unpacking ECC Secret Keys.
+void ECCTypes::SecretKey::msgpack_unpack(msgpack::object const& o) {
+  sk.Initialize(CryptoPP::ASN1::secp256r1(), unpackInteger(o));
+};
+
+// Packing ECC Public Keys, as the compressed public point.
+template <typename Packer> void ECCTypes::PublicKey::msgpack_pack(Packer& pk) const {
+  const CryptoPP::ECP &curve = this->pk.GetGroupParameters().GetCurve();
+  std::vector<unsigned char> point(curve.EncodedPointSize(true));
+  curve.EncodePoint(point.data(), this->pk.GetPublicElement(), true);
+
+  pk.pack_bin(point.size());
+  pk.pack_bin_body((const char *) point.data(), point.size());
+};
+
+// Unpacking ECC Public Keys.
+void ECCTypes::PublicKey::msgpack_unpack(msgpack::object const& o) {
+  if (o.type != msgpack::type::BIN) { throw msgpack::type_error(); }
+  CryptoPP::DL_GroupParameters_EC<CryptoPP::ECP> params(CryptoPP::ASN1::secp256r1());
+  CryptoPP::ECP::Point point;
+
+  if (!params.GetCurve().DecodePoint(point, (const unsigned char *) o.via.bin.ptr, o.via.bin.size) ||
+      !params.GetCurve().VerifyPoint(point)) {
+    throw msgpack::type_error();
+  }
+  this->pk.Initialize(params, point);
 };
 
 #endif
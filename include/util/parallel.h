@@ -0,0 +1,61 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <exception>
+
+/* Helpers for splitting independent work across threads.
+ */
+
+// Gives whether the calling thread is running a chunk of a parallelFor alongside other chunks, so already shares the
+// cores with them, and should not start threads of its own.
+inline bool &inParallelFor() {
+  static thread_local bool running = false;
+  return running;
+}
+
+// Calls f(begin, end) on contiguous chunks covering [0, n), using up to the given number of threads. Each index is handled exactly once, so writing results by index keeps the output independent of the thread count. If any chunk throws, the first exception is rethrown once every thread has finished.
+template <class F>
+inline void parallelFor(int threads, size_t n, F f) {
+  size_t chunks = std::min((size_t) std::max(threads, 1), n);
+
+  if (chunks <= 1) {
+    f((size_t) 0, n);
+    return;
+  }
+
+  std::vector<std::exception_ptr> errors(chunks);
+  auto run = [&f, &errors, n, chunks](size_t t) {
+    bool outer = inParallelFor();
+    inParallelFor() = true;
+
+    try {
+      f(t * n / chunks, (t + 1) * n / chunks);
+    } catch (...) {
+      errors[t] = std::current_exception();
+    }
+
+    inParallelFor() = outer;
+  };
+
+  std::vector<std::thread> workers;
+  for (size_t t = 1; t < chunks; t++) {
+    workers.push_back(std::thread(run, t));
+  }
+
+  run(0);
+
+  for (auto &worker: workers) {
+    worker.join();
+  }
+
+  for (auto &error: errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+};
+
+#endif
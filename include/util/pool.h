@@ -0,0 +1,118 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <exception>
+#include <stdexcept>
+#include <functional>
+#include <condition_variable>
+
+/* A bounded pool of items made ahead of time by background threads, for
+ * moving work that does not depend on its input out of a latency critical
+ * call.
+ */
+
+template <class T>
+class RefillPool {
+ public:
+  // Starts the given number of threads, calling produce to keep up to depth items ready. depth must be positive.
+  RefillPool(size_t depth, int threads, std::function<void(T &)> produce):
+    depth(depth), producing(0), stopping(false), produce(produce) {
+    if (depth == 0) {
+      throw std::runtime_error("A refill pool needs a positive depth.");
+    }
+
+    for (int t = 0; t < std::max(threads, 1); t++) {
+      workers.push_back(std::thread(&RefillPool::refill, this));
+    }
+  };
+
+  // Stops the threads, after they finish the items they are making.
+  ~RefillPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    notFull.notify_all();
+
+    for (auto &worker: workers) {
+      worker.join();
+    }
+  };
+
+  // Takes an item out of the pool, so it is never given out twice, waiting for one if none are ready. Rethrows
+  // the exception instead if produce threw while making it.
+  T take() {
+    std::unique_lock<std::mutex> lock(mutex);
+    notEmpty.wait(lock, [this] { return !items.empty() || !errors.empty(); });
+
+    if (!errors.empty()) {
+      std::exception_ptr error = errors.front();
+      errors.pop_front();
+      lock.unlock();
+
+      notFull.notify_one();
+      std::rethrow_exception(error);
+    }
+
+    T item = std::move(items.front());
+    items.pop_front();
+    lock.unlock();
+
+    notFull.notify_one();
+    return item;
+  };
+
+  // Gives the number of items ready, counting the exceptions take will rethrow in place of items, so waiting for
+  // the pool to fill ends even if produce throws.
+  size_t ready() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return items.size() + errors.size();
+  };
+
+ private:
+  void refill() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+      notFull.wait(lock, [this] { return stopping || items.size() + errors.size() + producing < depth; });
+      if (stopping) {
+        return;
+      }
+
+      producing++;
+      lock.unlock();
+
+      T item;
+      std::exception_ptr error;
+      try {
+        produce(item);
+      } catch (...) {
+        error = std::current_exception();
+      }
+
+      lock.lock();
+      if (error) {
+        errors.push_back(error);
+      } else {
+        items.push_back(std::move(item));
+      }
+      producing--;
+      notEmpty.notify_one();
+    }
+  };
+
+  size_t depth, producing;
+  bool stopping;
+  std::function<void(T &)> produce;
+  std::deque<T> items;
+  std::deque<std::exception_ptr> errors; // from produce, each given out by take in place of an item
+  std::mutex mutex;
+  std::condition_variable notEmpty, notFull;
+  std::vector<std::thread> workers;
+};
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include <emmintrin.h>
+#include <crypto++/cryptlib.h>
+
+#include "pke/aesni.h"
+
+/* A random generator for each thread: AES-128 in counter mode, under a key
+ * seeded once from the OS. The key is replaced with fresh output after
+ * every refill, so earlier output can not be recovered from the state.
+ * Every thread has its own key, and so its own stream.
+ */
+
+// Blocks of output made at a time, with the key for the next refill.
+#define RANDOM_BUFFER_BLOCKS 64
+
+class AesCtrRandom : public CryptoPP::RandomNumberGenerator {
+ public:
+  typedef uint64_t result_type;
+
+  // Seeds the key from the OS.
+  AesCtrRandom();
+
+  // Fills output with size random bytes.
+  virtual void GenerateBlock(unsigned char *output, size_t size);
+
+  // Fills blocks with n random blocks.
+  void fillBlocks(__m128i *blocks, size_t n);
+
+  // Gives a uniform integer in [0, n), for n > 0.
+  uint64_t uniform(uint64_t n);
+
+  // Gives 64 random bits, so this can be used with std::shuffle.
+  result_type operator()();
+
+  static constexpr result_type min() { return 0; }
+
+  static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+ private:
+  // Makes the next RANDOM_BUFFER_BLOCKS - 1 blocks of output into buffer, and rekeys.
+  void refill();
+
+  __m128i roundKeys[AESNI_ROUNDS + 1];
+  __m128i buffer[RANDOM_BUFFER_BLOCKS];
+  uint64_t counter;
+  size_t used; // bytes of the output in buffer already given out
+};
+
+// Gives the generator of the calling thread, seeding it on first use.
+AesCtrRandom &threadRandom();
+
+#endif
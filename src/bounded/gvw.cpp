@@ -2,14 +2,24 @@
 #include <iostream>
 #include <fstream>
 #include <assert.h>
+#include <algorithm>
 
 #include <NTL/lzz_pX.h>
 
 #include "oneqfe/ss.h"
 #include "bounded/gvw.h"
+#include "util/random.h"
+
+// Sets f to a uniformly random polynomial of degree less than n.
+static void randomPoly(NTL::zz_pX &f, long n) {
+  f = NTL::zz_pX();
+  for (long i = 0; i < n; i++) {
+    NTL::SetCoeff(f, i, (long) threadRandom().uniform(NTL::zz_p::modulus()));
+  }
+}
 
 template<class OneQS>
-GVW<OneQS>::GVW(int keys, int depth, int kappa, int modulus, bool useDelta, CircuitDescription *description) {
+GVW<OneQS>::GVW(int keys, int depth, int kappa, int modulus, bool useDelta, CircuitDescription *description, int threads, GarblingScheme scheme, bool seededKeys) {
   key_limit = keys;
   this->depth = depth;
   secret_shares = key_limit * key_limit * kappa;
@@ -22,13 +32,14 @@ GVW<OneQS>::GVW(int keys, int depth, int kappa, int modulus, bool useDelta, Circ
   if (useDelta) {
     description = new InnerProductModPDeltaCircuitDescription(description->getMod(), description->circuit_size/description->getModBits(), delta_pool_size);
   }
-  oneqfe = new OneQS(description);
+  oneqfeDescription = description;
+  oneqfe = new OneQS(description, threads, scheme, seededKeys);
   assert(modulus > total_shares);
   NTL::zz_p::init(modulus);
 }
 
 template<class OneQS>
-GVW<OneQS>::GVW(int keys, int depth, int secret_shares, int total_shares, int delta_size, int delta_pool_size, int modulus, bool useDelta, CircuitDescription *description) {
+GVW<OneQS>::GVW(int keys, int depth, int secret_shares, int total_shares, int delta_size, int delta_pool_size, int modulus, bool useDelta, CircuitDescription *description, int threads, GarblingScheme scheme, bool seededKeys) {
   key_limit = keys;
   this->depth = depth;
   this->total_shares = total_shares;
@@ -41,7 +52,8 @@ GVW<OneQS>::GVW(int keys, int depth, int secret_shares, int total_shares, int de
   if (useDelta) {
     description = new InnerProductModPDeltaCircuitDescription(description->getMod(), description->circuit_size/description->getModBits(), delta_pool_size);
   }
-  oneqfe = new OneQS(description);
+  oneqfeDescription = description;
+  oneqfe = new OneQS(description, threads, scheme, seededKeys);
   assert(modulus > total_shares);
   NTL::zz_p::init(modulus);
 }
@@ -70,7 +82,7 @@ typename GVW<OneQS>::SecretKey GVW<OneQS>::KeyGen(typename GVW<OneQS>::MasterSec
   for (size_t i = 0; i < sk.Gamma.size(); i++) {
     sk.Gamma[i] = i;
   }
-  std::random_shuffle(sk.Gamma.begin(), sk.Gamma.end());
+  std::shuffle(sk.Gamma.begin(), sk.Gamma.end(), threadRandom());
   sk.Gamma.resize(secret_shares * depth + 1);
 
   if (useDelta) {
@@ -79,7 +91,7 @@ typename GVW<OneQS>::SecretKey GVW<OneQS>::KeyGen(typename GVW<OneQS>::MasterSec
     for (size_t i = 0; i < sk.Delta.size(); i++) {
       sk.Delta[i] = i;
     }
-    std::random_shuffle(sk.Delta.begin(), sk.Delta.end());
+    std::shuffle(sk.Delta.begin(), sk.Delta.end(), threadRandom());
     sk.Delta.resize(delta_size);
 
     circuit = new InnerProductModPDeltaCircuit(*((InnerProductModPCircuit *) circuit), delta_pool_size, sk.Delta);
@@ -99,14 +111,14 @@ typename GVW<OneQS>::CipherText GVW<OneQS>::Encrypt(typename GVW<OneQS>::MasterP
 
   // Randomize polynomials
   for (size_t i = 0; i < msg.size(); i++) {
-    NTL::random(msg_polys[i], (long) secret_shares);
+    randomPoly(msg_polys[i], (long) secret_shares);
     NTL::SetCoeff(msg_polys[i], 0, msg[i]);
   }
 
   // Randomize zeta polynomials if using
   if (useDelta) {
     for (int i = 0; i < delta_pool_size; i++) {
-      NTL::random(zeta_polys[i], (long) (secret_shares * depth));
+      randomPoly(zeta_polys[i], (long) (secret_shares * depth));
       NTL::SetCoeff(zeta_polys[i], 0, 0);
     }
   }
@@ -145,7 +157,7 @@ typename GVW<OneQS>::CipherText GVW<OneQS>::Encrypt(typename GVW<OneQS>::MasterP
 }
 
 template<class OneQS>
-std::vector<int> GVW<OneQS>::Decrypt(typename GVW<OneQS>::SecretKey sk, typename GVW<OneQS>::CipherText ct) {
+std::vector<int> GVW<OneQS>::Decrypt(const typename GVW<OneQS>::SecretKey &sk, const typename GVW<OneQS>::CipherText &ct) {
   std::vector<std::vector<int> > poly_outputs(sk.Gamma.size());
 
   // decrypt points on each polynomial
@@ -181,3 +193,5 @@ template class GVW<SS_AES>;
 template class GVW<SS_RSA>;
 template class GVW<SS_SingletonAES>;
 template class GVW<SS_SingletonRSA>;
+template class GVW<SS_ECC>;
+template class GVW<SS_SingletonECC>;
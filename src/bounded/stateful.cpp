@@ -9,9 +9,9 @@
 #include "bounded/stateful.h"
 
 template<class OneQS>
-StatefulFE<OneQS>::StatefulFE(int keys, CircuitDescription *description) {
+StatefulFE<OneQS>::StatefulFE(int keys, CircuitDescription *description, int threads, GarblingScheme scheme, bool seededKeys) {
   key_limit = keys;
-  oneqfe = new OneQS(description);
+  oneqfe = new OneQS(description, threads, scheme, seededKeys);
   state = 0;
 }
 
@@ -57,7 +57,7 @@ typename StatefulFE<OneQS>::CipherText StatefulFE<OneQS>::Encrypt(typename State
 }
 
 template<class OneQS>
-std::vector<int> StatefulFE<OneQS>::Decrypt(typename StatefulFE<OneQS>::SecretKey sk, typename StatefulFE<OneQS>::CipherText ct) {
+std::vector<int> StatefulFE<OneQS>::Decrypt(const typename StatefulFE<OneQS>::SecretKey &sk, const typename StatefulFE<OneQS>::CipherText &ct) {
   return oneqfe->Decrypt(sk.sk, ct.cts[sk.index]);
 }
 
@@ -65,3 +65,5 @@ template class StatefulFE<SS_AES>;
 template class StatefulFE<SS_RSA>;
 template class StatefulFE<SS_SingletonAES>;
 template class StatefulFE<SS_SingletonRSA>;
+template class StatefulFE<SS_ECC>;
+template class StatefulFE<SS_SingletonECC>;
@@ -1,17 +1,42 @@
+#include <vector>
 #include <cstring>
+#include <algorithm>
 
 #include "circuit/circuit.h"
 #include "circuit/circuit_utils.h"
+#include "circuit/circuit_statistics.h"
 #include "circuit/inner_product_circuit.h"
 
 #include "libgarble/garble.h"
 #include "libgarble/circuit_builder.h"
 #include "libgarble/circuits.h"
 
+void addDeltaUnreduced(garble_circuit *circuit, garble_context *context,
+              int delta_pool_size, std::vector<int> &sum, int* zetas, int* delta, int len) {
+  GadgetScope scope("addDeltaUnreduced");
+  std::vector<int> tempWires(len), deltaSum;
+
+  for (int i = 0; i < delta_pool_size; i++) {
+    // Select either the ith value of the delta pool, or 0, based
+    // on whether delta[i] == 1 and add it to the output
+    for (int j = 0; j < len; j++) {
+      tempWires[j] = gateAND(circuit, context, zetas[i * len + j], delta[i]);
+    }
+
+    accumulate(circuit, context, deltaSum, tempWires.data(), len, len + ceilLog2(i + 1));
+  }
+
+  // Delta is summed on its own first, as it is much narrower than the sum it is added to.
+  if (!deltaSum.empty()) {
+    int maxLen = std::max((int) sum.size(), (int) deltaSum.size()) + 1;
+    accumulate(circuit, context, sum, deltaSum.data(), deltaSum.size(), maxLen);
+  }
+}
+
 void addDelta(garble_circuit *circuit, garble_context *context, 
               int delta_pool_size, int* existing, int* zetas, int* delta, int* outputs, int len, int p) {
-  std::vector<int> sumWires(len), tempWires(len);
-  std::memcpy(sumWires.data(), existing, len * sizeof(int));
+  GadgetScope scope("addDelta");
+  std::vector<int> sumWires(existing, existing + len);
 
   int parr[len];
   int mod = p;
@@ -25,15 +50,6 @@ void addDelta(garble_circuit *circuit, garble_context *context,
     mod /= 2;
   }
 
-  for (int i = 0; i < delta_pool_size; i++) {
-    // Select either the ith value of the delta pool, or 0, based
-    // on whether delta[i] == 1 and add it to the output
-    for (int j = 0; j < len; j++) {
-      tempWires[j] = builder_next_wire(context);
-      gate_AND(circuit, context, zetas[i * len + j], delta[i], tempWires[j]);
-    }
-    addModP(circuit, context, sumWires.data(), tempWires.data(), outputs, len, parr);
-
-    std::memcpy(sumWires.data(), outputs, len * sizeof(int));
-  }
+  addDeltaUnreduced(circuit, context, delta_pool_size, sumWires, zetas, delta, len);
+  reduceWideModP(circuit, context, sumWires.data(), sumWires.size(), outputs, len, parr);
 }
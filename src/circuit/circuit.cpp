@@ -7,6 +7,7 @@
 #include "circuit/hamming_circuit.h"
 #include "circuit/levenshtein_circuit.h"
 #include "circuit/add_delta.h"
+#include "circuit/legacy_circuit.h"
 
 #include "libgarble/garble.h"
 #include "libgarble/circuit_builder.h"
@@ -23,12 +24,19 @@ void InnerProductModPCircuitDescription::fillUniversalCircuit(garble_circuit *ci
 }
 
 void InnerProductModPDeltaCircuitDescription::fillUniversalCircuit(garble_circuit *circuit, garble_context *context, std::vector<int> inputs, std::vector<int> &outputs) {
-  std::vector<int> tempOuts(output_size);
+  std::vector<int> sum;
 
   int inner_prod_size = input_size - delta_pool_size * modBits;
 
-  innerProductCircuit(circuit, context, inner_prod_size, input_size, inputs.data(), tempOuts.data(), modBits, mod);
-  addDelta(circuit, context, delta_pool_size, tempOuts.data(), inputs.data() + inner_prod_size, inputs.data() + input_size + inner_prod_size, outputs.data(), modBits, mod);
+  int parr[modBits];
+  for (int i = 0; i < modBits; i++) {
+    parr[i] = (mod >> i) % 2;
+  }
+
+  // Both the inner product and Delta are added up without reduction, and only the total is reduced mod p.
+  innerProductUnreducedCircuit(circuit, context, inner_prod_size, input_size, inputs.data(), sum, modBits);
+  addDeltaUnreduced(circuit, context, delta_pool_size, sum, inputs.data() + inner_prod_size, inputs.data() + input_size + inner_prod_size, modBits);
+  reduceWideModP(circuit, context, sum.data(), sum.size(), outputs.data(), modBits, parr);
 }
 
 void HammingCircuitDescription::fillUniversalCircuit(garble_circuit *circuit, garble_context *context, std::vector<int> inputs, std::vector<int> &outputs) {
@@ -36,5 +44,41 @@ void HammingCircuitDescription::fillUniversalCircuit(garble_circuit *circuit, ga
 }
 
 void LevenshteinCircuitDescription::fillUniversalCircuit(garble_circuit *circuit, garble_context *context, std::vector<int> inputs, std::vector<int> &outputs) {
-  levenshteinCircuit(circuit, context, inputs.data(), outputs.data(), inputLen, circuitLen, alphabetBits);
+  levenshteinDiffCircuit(circuit, context, inputs.data(), outputs.data(), inputLen, circuitLen, alphabetBits);
+}
+
+void BandedLevenshteinCircuitDescription::fillUniversalCircuit(garble_circuit *circuit, garble_context *context, std::vector<int> inputs, std::vector<int> &outputs) {
+  bandedLevenshteinCircuit(circuit, context, inputs.data(), outputs.data(), inputLen, circuitLen, alphabetBits, threshold);
+}
+
+/* Create the legacy universal circuit for each type of circuit that had one.
+ */
+
+void ParityCircuitDescription::fillLegacyUniversalCircuit(garble_circuit *circuit, garble_context *context, std::vector<int> inputs, std::vector<int> &outputs) {
+  legacyParityCircuit(circuit, context, input_size, inputs.data(), outputs.data());
+}
+
+void InnerProductModPCircuitDescription::fillLegacyUniversalCircuit(garble_circuit *circuit, garble_context *context, std::vector<int> inputs, std::vector<int> &outputs) {
+  legacyInnerProductCircuit(circuit, context, input_size, input_size, inputs.data(), outputs.data(), modBits, mod);
+}
+
+void InnerProductModPDeltaCircuitDescription::fillLegacyUniversalCircuit(garble_circuit *circuit, garble_context *context, std::vector<int> inputs, std::vector<int> &outputs) {
+  std::vector<int> tempOuts(output_size);
+
+  int inner_prod_size = input_size - delta_pool_size * modBits;
+
+  legacyInnerProductCircuit(circuit, context, inner_prod_size, input_size, inputs.data(), tempOuts.data(), modBits, mod);
+  legacyAddDelta(circuit, context, delta_pool_size, tempOuts.data(), inputs.data() + inner_prod_size, inputs.data() + input_size + inner_prod_size, outputs.data(), modBits, mod);
+}
+
+void HammingCircuitDescription::fillLegacyUniversalCircuit(garble_circuit *circuit, garble_context *context, std::vector<int> inputs, std::vector<int> &outputs) {
+  legacyHammingCircuit(circuit, context, input_size, inputs.data(), outputs.data());
+}
+
+void LevenshteinCircuitDescription::fillLegacyUniversalCircuit(garble_circuit *circuit, garble_context *context, std::vector<int> inputs, std::vector<int> &outputs) {
+  legacyLevenshteinCircuit(circuit, context, inputs.data(), outputs.data(), inputLen, circuitLen, alphabetBits);
+}
+
+void BandedLevenshteinCircuitDescription::fillLegacyUniversalCircuit(garble_circuit *circuit, garble_context *context, std::vector<int> inputs, std::vector<int> &outputs) {
+  CircuitDescription::fillLegacyUniversalCircuit(circuit, context, inputs, outputs);
 }
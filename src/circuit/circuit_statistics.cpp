@@ -0,0 +1,125 @@
+#include <vector>
+#include <algorithm>
+
+#include "circuit/circuit_statistics.h"
+
+#include "libgarble/garble.h"
+
+// The statistics being recorded on this thread, if any, and the gadgets currently being built, outermost first.
+static thread_local CircuitStatistics *recording = nullptr;
+static thread_local std::vector<GadgetStatistics *> openGadgets;
+
+void countGates(const garble_circuit *circuit, CircuitStatistics &stats) {
+  std::vector<int> depth(circuit->r, 0);
+
+  stats.andGates = stats.orGates = stats.xorGates = stats.notGates = stats.constantGates = 0;
+  stats.wires = circuit->r;
+  stats.multiplicativeDepth = 0;
+
+  // The builder adds gates in topological order, so every input depth is known by the time a gate is reached.
+  for (size_t i = 0; i < circuit->q; i++) {
+    const garble_gate &gate = circuit->gates[i];
+
+    switch (gate.type) {
+      case GARBLE_GATE_AND:
+        stats.andGates++;
+        depth[gate.output] = std::max(depth[gate.input0], depth[gate.input1]) + 1;
+        break;
+      case GARBLE_GATE_OR:
+        stats.orGates++;
+        depth[gate.output] = std::max(depth[gate.input0], depth[gate.input1]) + 1;
+        break;
+      case GARBLE_GATE_XOR:
+        stats.xorGates++;
+        depth[gate.output] = std::max(depth[gate.input0], depth[gate.input1]);
+        break;
+      case GARBLE_GATE_NOT:
+        stats.notGates++;
+        depth[gate.output] = depth[gate.input0];
+        break;
+      default:
+        stats.constantGates++;
+        depth[gate.output] = 0;
+    }
+  }
+
+  for (size_t i = 0; i < circuit->m; i++) {
+    stats.multiplicativeDepth = std::max(stats.multiplicativeDepth, depth[circuit->outputs[i]]);
+  }
+}
+
+std::ostream &operator<<(std::ostream &out, const CircuitStatistics &stats) {
+  out << "Circuit non-XOR gates: " << stats.nonXOR() << std::endl;
+  out << "Circuit AND gates: " << stats.andGates << std::endl;
+  out << "Circuit OR gates: " << stats.orGates << std::endl;
+  out << "Circuit XOR gates: " << stats.xorGates << std::endl;
+  out << "Circuit NOT gates: " << stats.notGates << std::endl;
+  out << "Circuit wires: " << stats.wires << std::endl;
+  out << "Circuit multiplicative depth: " << stats.multiplicativeDepth << std::endl;
+
+  for (auto &gadget: stats.gadgets) {
+    out << "Gadget " << gadget.first << ": " << gadget.second.calls << " calls, "
+        << gadget.second.nonXOR() << " non-XOR gates, " << gadget.second.xorGates << " XOR gates" << std::endl;
+  }
+
+  return out;
+}
+
+GadgetRecorder::GadgetRecorder(CircuitStatistics &stats): previous(recording) {
+  recording = &stats;
+  previousGadgets.swap(openGadgets);
+}
+
+GadgetRecorder::~GadgetRecorder() {
+  recording = previous;
+  openGadgets.swap(previousGadgets);
+}
+
+GadgetScope::GadgetScope(const char *name): pushed(false) {
+  if (recording == nullptr) {
+    return;
+  }
+
+  GadgetStatistics *gadget = &recording->gadgets[name];
+  if (std::find(openGadgets.begin(), openGadgets.end(), gadget) == openGadgets.end()) {
+    gadget->calls++;
+    openGadgets.push_back(gadget);
+    pushed = true;
+  }
+}
+
+GadgetScope::~GadgetScope() {
+  if (pushed) {
+    openGadgets.pop_back();
+  }
+}
+
+static void countGate(GadgetStatistics &gadget, garble_gate_type_e type) {
+  switch (type) {
+    case GARBLE_GATE_AND:
+      gadget.andGates++;
+      break;
+    case GARBLE_GATE_OR:
+      gadget.orGates++;
+      break;
+    case GARBLE_GATE_XOR:
+      gadget.xorGates++;
+      break;
+    default:
+      gadget.notGates++;
+  }
+}
+
+void recordGate(garble_gate_type_e type) {
+  if (recording == nullptr) {
+    return;
+  }
+
+  if (openGadgets.empty()) {
+    countGate(recording->gadgets["other"], type);
+  }
+
+  for (GadgetStatistics *gadget: openGadgets) {
+    countGate(*gadget, type);
+  }
+}
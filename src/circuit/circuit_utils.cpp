@@ -6,58 +6,108 @@
 #include <cmath>
 
 #include "circuit/circuit.h"
+#include "circuit/circuit_utils.h"
+#include "circuit/circuit_statistics.h"
 
 #include "libgarble/garble.h"
 #include "libgarble/circuit_builder.h"
 #include "libgarble/circuits.h"
 
+int gateAND(garble_circuit *circuit, garble_context *context, int in0, int in1) {
+  if (in0 == wire_zero(circuit) || in1 == wire_zero(circuit)) {
+    return wire_zero(circuit);
+  }
+  if (in0 == wire_one(circuit) || in0 == in1) {
+    return in1;
+  }
+  if (in1 == wire_one(circuit)) {
+    return in0;
+  }
+
+  int out = builder_next_wire(context);
+  gate_AND(circuit, context, in0, in1, out);
+  recordGate(GARBLE_GATE_AND);
+  return out;
+}
+
+int gateXOR(garble_circuit *circuit, garble_context *context, int in0, int in1) {
+  if (in0 == in1) {
+    return wire_zero(circuit);
+  }
+  if (in0 == wire_zero(circuit)) {
+    return in1;
+  }
+  if (in1 == wire_zero(circuit)) {
+    return in0;
+  }
+  if (in0 == wire_one(circuit) && in1 == wire_one(circuit)) {
+    return wire_zero(circuit);
+  }
+
+  int out = builder_next_wire(context);
+  gate_XOR(circuit, context, in0, in1, out);
+  recordGate(GARBLE_GATE_XOR);
+  return out;
+}
+
+int gateOR(garble_circuit *circuit, garble_context *context, int in0, int in1) {
+  if (in0 == wire_one(circuit) || in1 == wire_one(circuit)) {
+    return wire_one(circuit);
+  }
+  if (in0 == wire_zero(circuit) || in0 == in1) {
+    return in1;
+  }
+  if (in1 == wire_zero(circuit)) {
+    return in0;
+  }
+
+  int out = builder_next_wire(context);
+  gate_OR(circuit, context, in0, in1, out);
+  recordGate(GARBLE_GATE_OR);
+  return out;
+}
+
+int gateNOT(garble_circuit *circuit, garble_context *context, int in) {
+  // XOR with the one wire is free, unlike a NOT gate.
+  return gateXOR(circuit, context, in, wire_one(circuit));
+}
+
 void mux(garble_circuit *circuit, garble_context *context,
              int *in1, int *in2, int deciderWire, int *out, int len) {
+  GadgetScope scope("mux");
   int internalWire1, internalWire2;
 
   for (int i = 0; i < len; i++) {
-    internalWire1 = builder_next_wire(context);
-    internalWire2 = builder_next_wire(context);
-    out[i] = builder_next_wire(context);
-
-    gate_XOR(circuit, context, in1[i], in2[i], internalWire1);
-    gate_AND(circuit, context, internalWire1, deciderWire, internalWire2);
-    gate_XOR(circuit, context, internalWire2, in2[i], out[i]);
+    internalWire1 = gateXOR(circuit, context, in1[i], in2[i]);
+    internalWire2 = gateAND(circuit, context, internalWire1, deciderWire);
+    out[i] = gateXOR(circuit, context, internalWire2, in2[i]);
   }
 }
 
 void neq(garble_circuit *circuit, garble_context *context,
          int* in1, int* in2, int* out, int len) {
-  int tmpWire1, tmpWire2;
+  GadgetScope scope("neq");
+  int tmpWire;
 
-  out[0] = builder_next_wire(context);
-  gate_XOR(circuit, context, in1[0], in2[0], out[0]);
+  out[0] = gateXOR(circuit, context, in1[0], in2[0]);
 
   for (int i = 1; i < len; i++) {
-    tmpWire1 = builder_next_wire(context);
-    tmpWire2 = builder_next_wire(context);
-    gate_XOR(circuit, context, in1[i], in2[i], tmpWire1);
-    gate_OR(circuit, context, out[0], tmpWire1, tmpWire2);
-    out[0] = tmpWire2;
+    tmpWire = gateXOR(circuit, context, in1[i], in2[i]);
+    out[0] = gateOR(circuit, context, out[0], tmpWire);
   }
 }
 
 void gteq(garble_circuit *circuit, garble_context *context,
            int *in1, int *in2, int *out, int len) {
+  GadgetScope scope("gteq");
   int carryWire = wire_one(circuit);
   int internalWire1, internalWire2, preCarryWire;
 
   for (int i = 0; i < len; i++) {
-    internalWire1 = builder_next_wire(context);
-    internalWire2 = builder_next_wire(context);
-    preCarryWire = builder_next_wire(context);
-
-    gate_XOR(circuit, context, in1[i], carryWire, internalWire1);
-    gate_XOR(circuit, context, in2[i], carryWire, internalWire2);
-    gate_AND(circuit, context, internalWire1, internalWire2, preCarryWire);
-
-    carryWire = builder_next_wire(context);
-    gate_XOR(circuit, context, in1[i], preCarryWire, carryWire);
+    internalWire1 = gateXOR(circuit, context, in1[i], carryWire);
+    internalWire2 = gateXOR(circuit, context, in2[i], carryWire);
+    preCarryWire = gateAND(circuit, context, internalWire1, internalWire2);
+    carryWire = gateXOR(circuit, context, in1[i], preCarryWire);
   }
 
   out[0] = carryWire;
@@ -66,52 +116,46 @@ void gteq(garble_circuit *circuit, garble_context *context,
 
 void min(garble_circuit *circuit, garble_context *context,
          int *in1, int *in2, int *out, int *minimal, int len) {
+  GadgetScope scope("min");
   gteq(circuit, context, in1, in2, minimal, len);
   mux(circuit, context, in2, in1, minimal[0], out, len);
 }
 
+void fullAdder(garble_circuit *circuit, garble_context *context,
+               int in1, int in2, int carryIn, int *sum, int *carryOut) {
+  GadgetScope scope("fullAdder");
+  // A single AND gate: the carry is ((a ^ c) & (b ^ c)) ^ c.
+  int internalWire1 = gateXOR(circuit, context, in1, carryIn);
+  int internalWire2 = gateXOR(circuit, context, in2, carryIn);
+  *sum = gateXOR(circuit, context, internalWire1, in2);
+  *carryOut = gateXOR(circuit, context, gateAND(circuit, context, internalWire1, internalWire2), carryIn);
+}
+
 void add(garble_circuit *circuit, garble_context *context,
            int* in1, int* in2, int* out, int len) {
-  int inputs[3], outputs[2];
-
-  inputs[0] = in1[0];
-  inputs[1] = in2[0];
+  GadgetScope scope("add");
+  int carryWire = wire_zero(circuit);
 
-  circuit_add22(circuit, context, inputs, outputs);
-  out[0] = outputs[0];
-  inputs[2] = outputs[1];
-
-  for (int i = 1; i < len; i++) {
-    inputs[0] = in1[i];
-    inputs[1] = in2[i];
-    circuit_add32(circuit, context, inputs, outputs);
-    out[i] = outputs[0];
-    inputs[2] = outputs[1];
+  for (int i = 0; i < len; i++) {
+    fullAdder(circuit, context, in1[i], in2[i], carryWire, &out[i], &carryWire);
   }
 
-  out[len] = outputs[1];
+  out[len] = carryWire;
 }
 
 void subtract(garble_circuit *circuit, garble_context *context,
            int* in1, int* in2, int* out, int *sign, int len) {
+  GadgetScope scope("subtract");
   int carryWire = wire_one(circuit);
   int internalWire1, internalWire2, preCarryWire, preOutWire;
 
   for (int i = 0; i < len; i++) {
-    internalWire1 = builder_next_wire(context);
-    internalWire2 = builder_next_wire(context);
-    preCarryWire = builder_next_wire(context);
-    preOutWire = builder_next_wire(context);
-    out[i] = builder_next_wire(context);
-
-    gate_XOR(circuit, context, in1[i], carryWire, internalWire1);
-    gate_XOR(circuit, context, in2[i], carryWire, internalWire2);
-    gate_XOR(circuit, context, in1[i], internalWire2, preOutWire);
-    gate_NOT(circuit, context, preOutWire, out[i]);
-    gate_AND(circuit, context, internalWire1, internalWire2, preCarryWire);
-
-    carryWire = builder_next_wire(context);
-    gate_XOR(circuit, context, in1[i], preCarryWire, carryWire);
+    internalWire1 = gateXOR(circuit, context, in1[i], carryWire);
+    internalWire2 = gateXOR(circuit, context, in2[i], carryWire);
+    preOutWire = gateXOR(circuit, context, in1[i], internalWire2);
+    out[i] = gateNOT(circuit, context, preOutWire);
+    preCarryWire = gateAND(circuit, context, internalWire1, internalWire2);
+    carryWire = gateXOR(circuit, context, in1[i], preCarryWire);
   }
 
   sign[0] = carryWire;
@@ -119,6 +163,7 @@ void subtract(garble_circuit *circuit, garble_context *context,
 
 void reduceModP(garble_circuit *circuit, garble_context *context,
                   int *in, int *out, int len, int *p) {
+  GadgetScope scope("reduceModP");
   int zeroWire = wire_zero(circuit);
   int oneWire = wire_one(circuit);
 
@@ -140,6 +185,7 @@ void reduceModP(garble_circuit *circuit, garble_context *context,
 
 void addModP(garble_circuit *circuit, garble_context *context,
                int *in1, int *in2, int *out, int len, int *p) {
+  GadgetScope scope("addModP");
   int sum[len+1];
   add(circuit, context, in1, in2, sum, len);
   reduceModP(circuit, context, sum, out, len, p);
@@ -147,6 +193,7 @@ void addModP(garble_circuit *circuit, garble_context *context,
 
 void multiplyBy2ModP(garble_circuit *circuit, garble_context *context,
                        int *in, int *out, int len, int *p) {
+  GadgetScope scope("multiplyBy2ModP");
   int internalWires[len + 1];
   
   internalWires[0] = wire_zero(circuit);
@@ -157,6 +204,7 @@ void multiplyBy2ModP(garble_circuit *circuit, garble_context *context,
 
 void multiplyModP(garble_circuit *circuit, garble_context *context,
                int* in1, int* in2, int *out, int len, int* p) {
+  GadgetScope scope("multiplyModP");
   int internalWires1[len], internalWires2[len];
   int zeroWire = wire_zero(circuit);
 
@@ -171,20 +219,174 @@ void multiplyModP(garble_circuit *circuit, garble_context *context,
   }
 }
 
+void reduceWideModP(garble_circuit *circuit, garble_context *context,
+                    int *in, int inLen, int *out, int len, int *p) {
+  GadgetScope scope("reduceWideModP");
+  int zeroWire = wire_zero(circuit);
+  int oneWire = wire_one(circuit);
+
+  if (inLen <= len) {
+    std::memcpy(out, in, inLen * sizeof(int));
+    for (int i = inLen; i < len; i++) {
+      out[i] = zeroWire;
+    }
+    return;
+  }
+
+  int pWires[len + 1], pLen = 1;
+  for (int i = 0; i < len; i++) {
+    if (p[i] == 1) {
+      pWires[i] = oneWire;
+      pLen = i + 1;
+    } else {
+      pWires[i] = zeroWire;
+    }
+  }
+  pWires[len] = zeroWire;
+
+  std::vector<int> rem(in, in + inLen);
+  rem.resize(inLen + len + 1, zeroWire);
+  int subtracted[len + 1], reduced[len], sign;
+
+  // Restoring division: before the step for shift s, rem < p * 2^(s+1), so only bits s..s+len of rem can change.
+  for (int s = inLen - pLen; s >= 0; s--) {
+    subtract(circuit, context, &rem[s], pWires, subtracted, &sign, len + 1);
+    mux(circuit, context, subtracted, &rem[s], sign, reduced, len);
+    std::memcpy(&rem[s], reduced, len * sizeof(int));
+    rem[s + len] = zeroWire;
+  }
+
+  std::memcpy(out, rem.data(), len * sizeof(int));
+}
+
+void accumulate(garble_circuit *circuit, garble_context *context,
+                std::vector<int> &sum, int *in, int len, int maxLen) {
+  GadgetScope scope("accumulate");
+  if (sum.empty()) {
+    sum.assign(in, in + len);
+    return;
+  }
+
+  int zeroWire = wire_zero(circuit);
+  int width = std::max((int) sum.size(), len);
+
+  std::vector<int> padded(in, in + len), out(width + 1);
+  sum.resize(width, zeroWire);
+  padded.resize(width, zeroWire);
+
+  add(circuit, context, sum.data(), padded.data(), out.data(), width);
+  out.resize(std::max(width, std::min(width + 1, maxLen)));
+  sum = out;
+}
+
+int ceilLog2(int x) {
+  int bits = 0;
+  while ((1LL << bits) < x) {
+    bits++;
+  }
+  return bits;
+}
+
+void multiplySchoolbook(garble_circuit *circuit, garble_context *context,
+                        int *in1, int *in2, int *out, int len) {
+  GadgetScope scope("multiplySchoolbook");
+  int zeroWire = wire_zero(circuit);
+  std::vector<int> row(len), sum(len + 1);
+
+  for (int i = 0; i < 2 * len; i++) {
+    out[i] = zeroWire;
+  }
+
+  for (int j = 0; j < len; j++) {
+    out[j] = gateAND(circuit, context, in1[j], in2[0]);
+  }
+
+  // Adds the partial product for bit i of in2 into bits i..i+len of out.
+  for (int i = 1; i < len; i++) {
+    for (int j = 0; j < len; j++) {
+      row[j] = gateAND(circuit, context, in1[j], in2[i]);
+    }
+
+    add(circuit, context, &out[i], row.data(), sum.data(), len);
+    std::memcpy(&out[i], sum.data(), (len + 1) * sizeof(int));
+  }
+}
+
+void multiplyKaratsuba(garble_circuit *circuit, garble_context *context,
+                       int *in1, int *in2, int *out, int len) {
+  GadgetScope scope("multiplyKaratsuba");
+  // The middle product has high + 1 bits, which is only smaller than len from 4 bits up.
+  if (len < KARATSUBA_CUTOFF || len < 4) {
+    multiplySchoolbook(circuit, context, in1, in2, out, len);
+    return;
+  }
+
+  int zeroWire = wire_zero(circuit);
+  int low = len / 2, high = len - low;
+
+  // Split each input as x1 * 2^low + x0, and pad the low halves to high bits.
+  std::vector<int> a0(in1, in1 + low), b0(in2, in2 + low);
+  a0.resize(high, zeroWire);
+  b0.resize(high, zeroWire);
+
+  std::vector<int> z0(2 * high), z2(2 * high), sumA(high + 1), sumB(high + 1), z1(2 * (high + 1));
+  int sign;
+
+  multiplyKaratsuba(circuit, context, a0.data(), b0.data(), z0.data(), high);
+  multiplyKaratsuba(circuit, context, in1 + low, in2 + low, z2.data(), high);
+
+  add(circuit, context, a0.data(), in1 + low, sumA.data(), high);
+  add(circuit, context, b0.data(), in2 + low, sumB.data(), high);
+  multiplyKaratsuba(circuit, context, sumA.data(), sumB.data(), z1.data(), high + 1);
+
+  // z1 - z0 - z2 = a0 * b1 + a1 * b0, which is nonnegative.
+  std::vector<int> padded(z1.size(), zeroWire), mid(z1.size());
+  std::memcpy(padded.data(), z0.data(), z0.size() * sizeof(int));
+  subtract(circuit, context, z1.data(), padded.data(), mid.data(), &sign, z1.size());
+  std::memcpy(padded.data(), z2.data(), z2.size() * sizeof(int));
+  subtract(circuit, context, mid.data(), padded.data(), z1.data(), &sign, z1.size());
+
+  // z0 and z2 * 2^(2 low) do not overlap, so only the middle term needs adding.
+  for (int i = 0; i < 2 * low; i++) {
+    out[i] = z0[i];
+  }
+  for (int i = 2 * low; i < 2 * len; i++) {
+    out[i] = z2[i - 2 * low];
+  }
+
+  int width = 2 * len - low;
+  std::vector<int> midWires(width, zeroWire), sum(width + 1);
+  for (int i = 0; i < std::min(width, (int) z1.size()); i++) {
+    midWires[i] = z1[i];
+  }
+
+  add(circuit, context, out + low, midWires.data(), sum.data(), width);
+  std::memcpy(out + low, sum.data(), width * sizeof(int));
+}
+
+void multiplyModPKaratsuba(garble_circuit *circuit, garble_context *context,
+                           int* in1, int* in2, int *out, int len, int* p) {
+  GadgetScope scope("multiplyModPKaratsuba");
+  std::vector<int> product(2 * len);
+
+  multiplyKaratsuba(circuit, context, in1, in2, product.data(), len);
+  reduceWideModP(circuit, context, product.data(), 2 * len, out, len, p);
+}
+
 void addGF2N(garble_circuit *circuit, garble_context *context,
                int* in1, int* in2, int *out, int n) {
+  GadgetScope scope("addGF2N");
   for (int i = 0; i < n; i++) {
-    out[i] = builder_next_wire(context);
-    gate_XOR(circuit, context, in1[i], in2[i], out[i]);
+    out[i] = gateXOR(circuit, context, in1[i], in2[i]);
   }
 }
 
 void reduceGF2NByIrredPoly(garble_circuit *circuit, garble_context *context,
                int* in, int *out, int n, int *irredPoly, int highCoeff) {
+  GadgetScope scope("reduceGF2NByIrredPoly");
   for (int i = 0; i < n; i ++) {
     if (irredPoly[i] == 1) {
-      out[i] = builder_next_wire(context);
-      gate_XOR(circuit, context, in[i], highCoeff, out[i]);
+      out[i] = gateXOR(circuit, context, in[i], highCoeff);
     } else if (irredPoly[i] == 0) {
       out[i] = in[i];
     } else {
@@ -195,6 +397,7 @@ void reduceGF2NByIrredPoly(garble_circuit *circuit, garble_context *context,
 
 void multiplyGF2N(garble_circuit *circuit, garble_context *context,
                int* in1, int* in2, int *out, int n, int *irredPoly) {
+  GadgetScope scope("multiplyGF2N");
   int internalWires1[n], internalWires2[n], highCoeff;
   int zeroWire = wire_zero(circuit);
 
@@ -212,8 +415,69 @@ void multiplyGF2N(garble_circuit *circuit, garble_context *context,
   }
 }
 
+void multiplyPolyGF2Karatsuba(garble_circuit *circuit, garble_context *context,
+                              int *in1, int *in2, int *out, int n) {
+  GadgetScope scope("multiplyPolyGF2Karatsuba");
+  if (n == 1) {
+    out[0] = gateAND(circuit, context, in1[0], in2[0]);
+    return;
+  }
+
+  int zeroWire = wire_zero(circuit);
+  int low = n / 2, high = n - low;
+
+  // Split each input as x1 * x^low + x0, and pad the low halves to high coefficients.
+  std::vector<int> a0(in1, in1 + low), b0(in2, in2 + low);
+  a0.resize(high, zeroWire);
+  b0.resize(high, zeroWire);
+
+  std::vector<int> z0(2 * high - 1), z1(2 * high - 1), z2(2 * high - 1), mid(2 * high - 1), sumA(high), sumB(high);
+
+  multiplyPolyGF2Karatsuba(circuit, context, a0.data(), b0.data(), z0.data(), high);
+  multiplyPolyGF2Karatsuba(circuit, context, in1 + low, in2 + low, z2.data(), high);
+
+  addGF2N(circuit, context, a0.data(), in1 + low, sumA.data(), high);
+  addGF2N(circuit, context, b0.data(), in2 + low, sumB.data(), high);
+  multiplyPolyGF2Karatsuba(circuit, context, sumA.data(), sumB.data(), z1.data(), high);
+
+  addGF2N(circuit, context, z1.data(), z0.data(), mid.data(), 2 * high - 1);
+  addGF2N(circuit, context, mid.data(), z2.data(), z1.data(), 2 * high - 1);
+
+  for (int i = 0; i < 2 * n - 1; i++) {
+    out[i] = zeroWire;
+  }
+  for (int i = 0; i < 2 * low - 1; i++) {
+    out[i] = z0[i];
+  }
+  for (int i = 0; i < 2 * high - 1; i++) {
+    out[i + 2 * low] = z2[i];
+  }
+
+  // Only the middle term overlaps the others, and addition is free.
+  for (int i = 0; i < 2 * high - 1 && i + low < 2 * n - 1; i++) {
+    out[i + low] = gateXOR(circuit, context, out[i + low], z1[i]);
+  }
+}
+
+void multiplyGF2NKaratsuba(garble_circuit *circuit, garble_context *context,
+                           int* in1, int* in2, int *out, int n, int *irredPoly) {
+  GadgetScope scope("multiplyGF2NKaratsuba");
+  std::vector<int> product(2 * n - 1), folded(n);
+
+  multiplyPolyGF2Karatsuba(circuit, context, in1, in2, product.data(), n);
+
+  // x^k = x^(k-n) * (x^n mod irredPoly), so fold the high coefficients down, starting at the top.
+  for (int k = 2 * n - 2; k >= n; k--) {
+    reduceGF2NByIrredPoly(circuit, context, &product[k - n], folded.data(), n, irredPoly, product[k]);
+    std::memcpy(&product[k - n], folded.data(), n * sizeof(int));
+  }
+
+  std::memcpy(out, product.data(), n * sizeof(int));
+}
+
 void add32(garble_circuit *circuit, garble_context *context,
            int* in1, int* in2, int* out) {
+  GadgetScope scope("add32");
   int tmpOut[33];
   
   add(circuit, context, in1, in2, tmpOut, 32);
@@ -223,6 +487,7 @@ void add32(garble_circuit *circuit, garble_context *context,
 
 void multiply32(garble_circuit *circuit, garble_context *context,
                int* in1, int* in2, int *out) {
+  GadgetScope scope("multiply32");
   int len = 32;
   int internalWires1[len], internalWires2[len];
   int zeroWire = wire_zero(circuit);
@@ -240,16 +505,111 @@ void multiply32(garble_circuit *circuit, garble_context *context,
   }
 }
 
-void hamming(garble_circuit *circuit, garble_context *context,
-               int* in1, int* in2, int *out, int len) {
+void multiplyLowKaratsuba(garble_circuit *circuit, garble_context *context,
+                          int* in1, int* in2, int *out, int len) {
+  GadgetScope scope("multiplyLowKaratsuba");
+  if (len < KARATSUBA_CUTOFF || len < 2) {
+    // Schoolbook, skipping partial products that only affect bits at len or above.
+    std::vector<int> row(len), sum(len + 1);
+
+    for (int j = 0; j < len; j++) {
+      out[j] = gateAND(circuit, context, in1[j], in2[0]);
+    }
+
+    for (int i = 1; i < len; i++) {
+      for (int j = 0; j < len - i; j++) {
+        row[j] = gateAND(circuit, context, in1[j], in2[i]);
+      }
+
+      add(circuit, context, &out[i], row.data(), sum.data(), len - i);
+      std::memcpy(&out[i], sum.data(), (len - i) * sizeof(int));
+    }
+    return;
+  }
+
+  // With x = x1 * 2^low + x0, the low len bits of a * b are a0 * b0 + (a0 * b1 + a1 * b0) * 2^low.
+  int low = (len + 1) / 2, high = len - low;
+  std::vector<int> z0(2 * low), cross1(high), cross2(high), crossSum(high + 1), sum(high + 1);
+
+  multiplyKaratsuba(circuit, context, in1, in2, z0.data(), low);
+  multiplyLowKaratsuba(circuit, context, in1, in2 + low, cross1.data(), high);
+  multiplyLowKaratsuba(circuit, context, in1 + low, in2, cross2.data(), high);
+
+  add(circuit, context, cross1.data(), cross2.data(), crossSum.data(), high);
+  add(circuit, context, &z0[low], crossSum.data(), sum.data(), high);
+
+  std::memcpy(out, z0.data(), low * sizeof(int));
+  std::memcpy(out + low, sum.data(), high * sizeof(int));
+}
+
+void multiply32Karatsuba(garble_circuit *circuit, garble_context *context,
+               int* in1, int* in2, int *out) {
+  GadgetScope scope("multiply32Karatsuba");
+  multiplyLowKaratsuba(circuit, context, in1, in2, out, 32);
+}
+
+void popcount(garble_circuit *circuit, garble_context *context,
+              int* in, int *out, int len) {
+  GadgetScope scope("popcount");
+  int outLen = ceilLog2(len + 1);
+  int zeroWire = wire_zero(circuit);
+
+  // columns[w] holds wires of weight 2^w. Each round replaces every three wires in a column with a full adder's sum
+  // in the same column and its carry in the next one, until every column has at most two wires left.
+  std::vector<std::vector<int> > columns(outLen + 1), next(outLen + 1);
+  columns[0].assign(in, in + len);
+
+  bool reduced = false;
+  while (!reduced) {
+    reduced = true;
+
+    for (auto &column: next) {
+      column.clear();
+    }
+
+    for (int w = 0; w < outLen; w++) {
+      size_t k = 0;
+      int sum, carry;
+
+      for (; k + 3 <= columns[w].size(); k += 3) {
+        fullAdder(circuit, context, columns[w][k], columns[w][k + 1], columns[w][k + 2], &sum, &carry);
+        next[w].push_back(sum);
+        next[w + 1].push_back(carry);
+      }
+
+      next[w].insert(next[w].end(), columns[w].begin() + k, columns[w].end());
+    }
+
+    columns.swap(next);
+
+    for (int w = 0; w < outLen; w++) {
+      reduced = reduced && columns[w].size() <= 2;
+    }
+  }
+
+  // Carries out of the top column are always zero, as the count fits in outLen bits.
+  std::vector<int> row1(outLen, zeroWire), row2(outLen, zeroWire), sum(outLen + 1);
+  for (int w = 0; w < outLen; w++) {
+    if (columns[w].size() > 0) {
+      row1[w] = columns[w][0];
+    }
+    if (columns[w].size() > 1) {
+      row2[w] = columns[w][1];
+    }
+  }
+
+  add(circuit, context, row1.data(), row2.data(), sum.data(), outLen);
+  std::memcpy(out, sum.data(), outLen * sizeof(int));
+}
+
+void popcountPairwise(garble_circuit *circuit, garble_context *context,
+              int* in, int *out, int len) {
+  GadgetScope scope("popcountPairwise");
   std::vector<int> oldDiffs(len + 1), newDiffs(len + 1);
   int width = 1;
   int sums = len;
 
-  for (int i = 0; i < len; i++) {
-    oldDiffs[i] = builder_next_wire(context);
-    gate_XOR(circuit, context, in1[i], in2[i], oldDiffs[i]);
-  }
+  std::memcpy(oldDiffs.data(), in, len * sizeof(int));
 
   while (sums > 1) {
     for (int i = 0; i < sums/2; i ++) {
@@ -268,12 +628,25 @@ void hamming(garble_circuit *circuit, garble_context *context,
     width += 1;
   }
 
-  std::memcpy(out, oldDiffs.data(), width * sizeof(int));
+  std::memcpy(out, oldDiffs.data(), ceilLog2(len + 1) * sizeof(int));
+}
+
+void hamming(garble_circuit *circuit, garble_context *context,
+               int* in1, int* in2, int *out, int len) {
+  GadgetScope scope("hamming");
+  std::vector<int> diffs(len);
+
+  for (int i = 0; i < len; i++) {
+    diffs[i] = gateXOR(circuit, context, in1[i], in2[i]);
+  }
+
+  popcount(circuit, context, diffs.data(), out, len);
 }
 
 void levenshteinCore(garble_circuit *circuit, garble_context *context,
                      std::vector<int> &xCand, std::vector<int> &yCand, std::vector<int> &diagCand, 
                      int *in1, int *in2, std::vector<int> &out, int alphabetBits) {
+  GadgetScope scope("levenshteinCore");
   int neqWire, isDiag, oneWire = wire_one(circuit);
   std::vector<int> min1Wires(out.size()), min2Wires(out.size()), increment(out.size(), wire_zero(circuit));
 
@@ -288,3 +661,21 @@ void levenshteinCore(garble_circuit *circuit, garble_context *context,
 
   out.resize(out.size() - 1);
 }
+
+void levenshteinDiffCore(garble_circuit *circuit, garble_context *context,
+                         int *hIn, int *vIn, int neqWire, int *hOut, int *vOut) {
+  GadgetScope scope("levenshteinDiffCore");
+  // With d the value of the diagonal cell, the cell is d + t, where t is 0 if the characters match or either
+  // neighbour is d - 1, and 1 otherwise.
+  int eitherMinus = gateOR(circuit, context, hIn[1], vIn[1]);
+  int t = gateAND(circuit, context, neqWire, gateNOT(circuit, context, eitherMinus));
+  int notT = gateNOT(circuit, context, t);
+
+  // The difference to the cell above is t - hIn, and to the cell on the left is t - vIn.
+  int notHPlus = gateNOT(circuit, context, hIn[0]);
+  int notVPlus = gateNOT(circuit, context, vIn[0]);
+  mux(circuit, context, &notHPlus, &hIn[1], t, &vOut[0], 1);
+  vOut[1] = gateAND(circuit, context, notT, hIn[0]);
+  mux(circuit, context, &notVPlus, &vIn[1], t, &hOut[0], 1);
+  hOut[1] = gateAND(circuit, context, notT, vIn[0]);
+}
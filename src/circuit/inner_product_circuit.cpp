@@ -1,3 +1,4 @@
+#include <vector>
 #include <cstring>
 
 #include "circuit/circuit.h"
@@ -8,15 +9,21 @@
 #include "libgarble/circuit_builder.h"
 #include "libgarble/circuits.h"
 
-void innerProductCircuit(garble_circuit *circuit, garble_context *context, 
-                  int n, int offset, int* inputs, int* outputs, int len, int p) {
-  int oldSumWires[len], newSumWires[len], productWires[len];
-  int zeroWire = wire_zero(circuit);
+void innerProductUnreducedCircuit(garble_circuit *circuit, garble_context *context,
+                  int n, int offset, int* inputs, std::vector<int> &sum, int len) {
+  std::vector<int> productWires(2 * len);
+  sum.clear();
 
-  for (int i = 0; i < len; i++) {
-    oldSumWires[i] = zeroWire;
+  for (int i = 0; i < n/len; i++) {
+    multiplyKaratsuba(circuit, context, &inputs[i * len], &inputs[i * len + offset], productWires.data(), len);
+
+    // i + 1 products of 2 * len bits each fit in 2 * len + ceilLog2(i + 1) bits.
+    accumulate(circuit, context, sum, productWires.data(), 2 * len, 2 * len + ceilLog2(i + 1));
   }
+}
 
+void innerProductCircuit(garble_circuit *circuit, garble_context *context, 
+                  int n, int offset, int* inputs, int* outputs, int len, int p) {
   int parr[len];
   int mod = p;
 
@@ -29,14 +36,10 @@ void innerProductCircuit(garble_circuit *circuit, garble_context *context,
     mod /= 2;
   }
 
-  for (int i = 0; i < n/len; i++) {
-    multiplyModP(circuit, context, &inputs[i * len], &inputs[i * len + offset], productWires, len, parr);
-    addModP(circuit, context, oldSumWires, productWires, newSumWires, len, parr);
-
-    std::memcpy(oldSumWires, newSumWires, len * sizeof(int));
-  }
-
-  std::memcpy(outputs, oldSumWires, len * sizeof(int));
+  // The products are summed without reduction, and the sum is reduced once at the end.
+  std::vector<int> sum;
+  innerProductUnreducedCircuit(circuit, context, n, offset, inputs, sum, len);
+  reduceWideModP(circuit, context, sum.data(), sum.size(), outputs, len, parr);
 }
 
 void innerProductGF2NCircuit(garble_circuit *circuit, garble_context *context, 
@@ -49,8 +52,13 @@ void innerProductGF2NCircuit(garble_circuit *circuit, garble_context *context,
   }
 
   for (int i = 0; i < n/len; i++) {
-    multiplyGF2N(circuit, context, &inputs[i * len], &inputs[i * len + n], 
-                 productWires, len, irredPoly);
+    if (len >= KARATSUBA_GF2N_MIN_BITS) {
+      multiplyGF2NKaratsuba(circuit, context, &inputs[i * len], &inputs[i * len + n],
+                            productWires, len, irredPoly);
+    } else {
+      multiplyGF2N(circuit, context, &inputs[i * len], &inputs[i * len + n], 
+                   productWires, len, irredPoly);
+    }
     addGF2N(circuit, context, oldSumWires, productWires, newSumWires, len);
 
     std::memcpy(oldSumWires, newSumWires, len * sizeof(int));
@@ -70,7 +78,7 @@ void innerProductCircuit32(garble_circuit *circuit, garble_context *context,
   }
 
   for (int i = 0; i < n/len; i++) {
-    multiply32(circuit, context, &inputs[i * len], &inputs[i * len + n], productWires);
+    multiply32Karatsuba(circuit, context, &inputs[i * len], &inputs[i * len + n], productWires);
     add32(circuit, context, oldSumWires, productWires, newSumWires);
 
     std::memcpy(oldSumWires, newSumWires, len * sizeof(int));
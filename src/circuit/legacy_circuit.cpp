@@ -0,0 +1,382 @@
+#include <vector>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#include "circuit/legacy_circuit.h"
+
+#include "libgarble/garble.h"
+#include "libgarble/circuit_builder.h"
+#include "libgarble/circuits.h"
+
+/* Copies of the gadgets the legacy universal circuits were built from, kept apart from circuit_utils so that later
+ * changes to those can not change these circuits.
+ */
+
+namespace {
+
+void mux(garble_circuit *circuit, garble_context *context,
+             int *in1, int *in2, int deciderWire, int *out, int len) {
+  int internalWire1, internalWire2;
+
+  for (int i = 0; i < len; i++) {
+    internalWire1 = builder_next_wire(context);
+    internalWire2 = builder_next_wire(context);
+    out[i] = builder_next_wire(context);
+
+    gate_XOR(circuit, context, in1[i], in2[i], internalWire1);
+    gate_AND(circuit, context, internalWire1, deciderWire, internalWire2);
+    gate_XOR(circuit, context, internalWire2, in2[i], out[i]);
+  }
+}
+
+void neq(garble_circuit *circuit, garble_context *context,
+         int* in1, int* in2, int* out, int len) {
+  int tmpWire1, tmpWire2;
+
+  out[0] = builder_next_wire(context);
+  gate_XOR(circuit, context, in1[0], in2[0], out[0]);
+
+  for (int i = 1; i < len; i++) {
+    tmpWire1 = builder_next_wire(context);
+    tmpWire2 = builder_next_wire(context);
+    gate_XOR(circuit, context, in1[i], in2[i], tmpWire1);
+    gate_OR(circuit, context, out[0], tmpWire1, tmpWire2);
+    out[0] = tmpWire2;
+  }
+}
+
+void gteq(garble_circuit *circuit, garble_context *context,
+           int *in1, int *in2, int *out, int len) {
+  int carryWire = wire_one(circuit);
+  int internalWire1, internalWire2, preCarryWire;
+
+  for (int i = 0; i < len; i++) {
+    internalWire1 = builder_next_wire(context);
+    internalWire2 = builder_next_wire(context);
+    preCarryWire = builder_next_wire(context);
+
+    gate_XOR(circuit, context, in1[i], carryWire, internalWire1);
+    gate_XOR(circuit, context, in2[i], carryWire, internalWire2);
+    gate_AND(circuit, context, internalWire1, internalWire2, preCarryWire);
+
+    carryWire = builder_next_wire(context);
+    gate_XOR(circuit, context, in1[i], preCarryWire, carryWire);
+  }
+
+  out[0] = carryWire;
+}
+
+void min(garble_circuit *circuit, garble_context *context,
+         int *in1, int *in2, int *out, int *minimal, int len) {
+  gteq(circuit, context, in1, in2, minimal, len);
+  mux(circuit, context, in2, in1, minimal[0], out, len);
+}
+
+void add(garble_circuit *circuit, garble_context *context,
+           int* in1, int* in2, int* out, int len) {
+  int inputs[3], outputs[2];
+
+  inputs[0] = in1[0];
+  inputs[1] = in2[0];
+
+  circuit_add22(circuit, context, inputs, outputs);
+  out[0] = outputs[0];
+  inputs[2] = outputs[1];
+
+  for (int i = 1; i < len; i++) {
+    inputs[0] = in1[i];
+    inputs[1] = in2[i];
+    circuit_add32(circuit, context, inputs, outputs);
+    out[i] = outputs[0];
+    inputs[2] = outputs[1];
+  }
+
+  out[len] = outputs[1];
+}
+
+void subtract(garble_circuit *circuit, garble_context *context,
+           int* in1, int* in2, int* out, int *sign, int len) {
+  int carryWire = wire_one(circuit);
+  int internalWire1, internalWire2, preCarryWire, preOutWire;
+
+  for (int i = 0; i < len; i++) {
+    internalWire1 = builder_next_wire(context);
+    internalWire2 = builder_next_wire(context);
+    preCarryWire = builder_next_wire(context);
+    preOutWire = builder_next_wire(context);
+    out[i] = builder_next_wire(context);
+
+    gate_XOR(circuit, context, in1[i], carryWire, internalWire1);
+    gate_XOR(circuit, context, in2[i], carryWire, internalWire2);
+    gate_XOR(circuit, context, in1[i], internalWire2, preOutWire);
+    gate_NOT(circuit, context, preOutWire, out[i]);
+    gate_AND(circuit, context, internalWire1, internalWire2, preCarryWire);
+
+    carryWire = builder_next_wire(context);
+    gate_XOR(circuit, context, in1[i], preCarryWire, carryWire);
+  }
+
+  sign[0] = carryWire;
+}
+
+void reduceModP(garble_circuit *circuit, garble_context *context,
+                  int *in, int *out, int len, int *p) {
+  int zeroWire = wire_zero(circuit);
+  int oneWire = wire_one(circuit);
+
+  int pWires[len+1];
+  for (int i = 0; i<len; i++) {
+    if (p[i] == 1) {
+      pWires[i] = oneWire;
+    } else {
+      pWires[i] = zeroWire;
+    }
+  }
+  pWires[len] = zeroWire;
+
+  int subtracted[len + 1], sign;
+  subtract(circuit, context, in, pWires, subtracted, &sign, len + 1);
+
+  mux(circuit, context, subtracted, in, sign, out, len);
+}
+
+void addModP(garble_circuit *circuit, garble_context *context,
+               int *in1, int *in2, int *out, int len, int *p) {
+  int sum[len+1];
+  add(circuit, context, in1, in2, sum, len);
+  reduceModP(circuit, context, sum, out, len, p);
+}
+
+void multiplyBy2ModP(garble_circuit *circuit, garble_context *context,
+                       int *in, int *out, int len, int *p) {
+  int internalWires[len + 1];
+  
+  internalWires[0] = wire_zero(circuit);
+  std::memcpy(&(internalWires[1]), in, len * sizeof(int));
+  
+  reduceModP(circuit, context, internalWires, out, len, p);
+}
+
+void multiplyModP(garble_circuit *circuit, garble_context *context,
+               int* in1, int* in2, int *out, int len, int* p) {
+  int internalWires1[len], internalWires2[len];
+  int zeroWire = wire_zero(circuit);
+
+  for (int i = 0; i < len; i++) {
+    out[i] = zeroWire;
+  }
+
+  for (int i = len - 1; i >= 0; i--) {
+    multiplyBy2ModP(circuit, context, out, internalWires1, len, p);
+    addModP(circuit, context, internalWires1, in2, internalWires2, len, p);
+    mux(circuit, context, internalWires2, internalWires1, in1[i], out, len);
+  }
+}
+
+void hamming(garble_circuit *circuit, garble_context *context,
+               int* in1, int* in2, int *out, int len) {
+  std::vector<int> oldDiffs(len + 1), newDiffs(len + 1);
+  int width = 1;
+  int sums = len;
+
+  for (int i = 0; i < len; i++) {
+    oldDiffs[i] = builder_next_wire(context);
+    gate_XOR(circuit, context, in1[i], in2[i], oldDiffs[i]);
+  }
+
+  while (sums > 1) {
+    for (int i = 0; i < sums/2; i ++) {
+      add(circuit, context, &oldDiffs[2 * i * width], &oldDiffs[(2 * i + 1) * width], &newDiffs[i * (width + 1)], width);
+    }
+
+    if (sums % 2 == 1) {
+      std::memcpy(&newDiffs[(sums / 2) * (width + 1)], &oldDiffs[(sums-1) * width], width * sizeof(int));
+      newDiffs[(sums / 2 + 1) * (width + 1) - 1] = wire_zero(circuit);
+    }
+
+
+    std::memcpy(oldDiffs.data(), newDiffs.data(), (len + 1) * sizeof(int));
+
+    sums = (sums + 1)/2;
+    width += 1;
+  }
+
+  std::memcpy(out, oldDiffs.data(), width * sizeof(int));
+}
+
+void levenshteinCore(garble_circuit *circuit, garble_context *context,
+                     std::vector<int> &xCand, std::vector<int> &yCand, std::vector<int> &diagCand, 
+                     int *in1, int *in2, std::vector<int> &out, int alphabetBits) {
+  int neqWire, isDiag, oneWire = wire_one(circuit);
+  std::vector<int> min1Wires(out.size()), min2Wires(out.size()), increment(out.size(), wire_zero(circuit));
+
+  min(circuit, context, xCand.data(), yCand.data(), min1Wires.data(), &isDiag, out.size());
+  min(circuit, context, min1Wires.data(), diagCand.data(), min2Wires.data(), &isDiag, out.size());
+  neq(circuit, context, in1, in2, &neqWire, alphabetBits);
+  mux(circuit, context, &neqWire, &oneWire, isDiag, increment.data(), 1);
+
+  out.resize(out.size() + 1);
+
+  add(circuit, context, min2Wires.data(), increment.data(), out.data(), out.size() - 1);
+
+  out.resize(out.size() - 1);
+}
+
+}
+
+void legacyParityCircuit(garble_circuit *circuit, garble_context *context,
+                         int n, int* inputs, int* outputs) {
+  int oldInternalWire = wire_zero(circuit);
+  int newInternalWire, productWire;
+
+  for (int i = 0; i < n; i++) {
+    productWire = builder_next_wire(context);
+    newInternalWire = builder_next_wire(context);
+    gate_AND(circuit, context, inputs[i], inputs[i + n], productWire);
+    gate_XOR(circuit, context, oldInternalWire, productWire, newInternalWire);
+    oldInternalWire=newInternalWire;
+  }
+
+  outputs[0] = oldInternalWire;
+}
+
+void legacyInnerProductCircuit(garble_circuit *circuit, garble_context *context,
+                               int n, int offset, int* inputs, int* outputs, int len, int p) {
+  int oldSumWires[len], newSumWires[len], productWires[len];
+  int zeroWire = wire_zero(circuit);
+
+  for (int i = 0; i < len; i++) {
+    oldSumWires[i] = zeroWire;
+  }
+
+  int parr[len];
+  int mod = p;
+
+  for (int i = 0; i < len; i++) {
+    if (mod % 2 == 0) {
+      parr[i] = 0;
+    } else {
+      parr[i] = 1;
+    }
+    mod /= 2;
+  }
+
+  for (int i = 0; i < n/len; i++) {
+    multiplyModP(circuit, context, &inputs[i * len], &inputs[i * len + offset], productWires, len, parr);
+    addModP(circuit, context, oldSumWires, productWires, newSumWires, len, parr);
+
+    std::memcpy(oldSumWires, newSumWires, len * sizeof(int));
+  }
+
+  std::memcpy(outputs, oldSumWires, len * sizeof(int));
+}
+
+void legacyAddDelta(garble_circuit *circuit, garble_context *context,
+                    int delta_pool_size, int* existing, int* zetas, int* delta, int* outputs, int len, int p) {
+  std::vector<int> sumWires(len), tempWires(len);
+  std::memcpy(sumWires.data(), existing, len * sizeof(int));
+
+  int parr[len];
+  int mod = p;
+
+  for (int i = 0; i < len; i++) {
+    if (mod % 2 == 0) {
+      parr[i] = 0;
+    } else {
+      parr[i] = 1;
+    }
+    mod /= 2;
+  }
+
+  for (int i = 0; i < delta_pool_size; i++) {
+    // Select either the ith value of the delta pool, or 0, based
+    // on whether delta[i] == 1 and add it to the output
+    for (int j = 0; j < len; j++) {
+      tempWires[j] = builder_next_wire(context);
+      gate_AND(circuit, context, zetas[i * len + j], delta[i], tempWires[j]);
+    }
+    addModP(circuit, context, sumWires.data(), tempWires.data(), outputs, len, parr);
+
+    std::memcpy(sumWires.data(), outputs, len * sizeof(int));
+  }
+}
+
+void legacyHammingCircuit(garble_circuit *circuit, garble_context *context,
+                          int n, int* inputs, int* outputs) {
+  hamming(circuit, context, inputs, inputs + n, outputs, n);
+}
+
+void legacyLevenshteinCircuit(garble_circuit *circuit, garble_context *context,
+                              int *inputs, int *out, int len1, int len2, int alphabetBits) {
+  // Table of partial levenshtein distances.
+  std::vector<std::vector<std::vector<int> > > vals(len1 + 1);
+
+  int *in1 = inputs;
+  int *in2 = inputs + len1 * alphabetBits;
+
+  int zeroWire = wire_zero(circuit);
+  int oneWire = wire_one(circuit);
+
+  // Initializing table entries to correct sizes and values
+  for (auto &i: vals) {
+    i.resize(len2 + 1);
+  }
+
+  for (int i = 0; i < len1 + 1; i++) {
+    for (int j = 0; j < len2 + 1; j++) {
+      int bits = (int) ceil(log2(std::max(i,j) + 1));
+      vals[i][j].resize(bits);
+    }
+  }
+
+  for (int i = 0; i < len1; i++) {
+    for (size_t j = 0; j < vals[i][0].size(); j++) {
+      if ((i >> j) % 2 == 0) {
+        vals[i][0][j] = zeroWire;
+      } else {
+        vals[i][0][j] = oneWire;
+      }
+    }
+  }
+
+  for (int i = 0; i < len2; i++) {
+    for (size_t j = 0; j < vals[0][i].size(); j++) {
+      if ((i >> j) % 2 == 0) {
+        vals[0][i][j] = zeroWire;
+      } else {
+        vals[0][i][j] = oneWire;
+      }
+    }
+  }
+
+  std::vector<int> xCand, yCand, diagCand;
+
+  // Populating table of partial values.
+  for (int i = 1; i < len1 + 1; i++) {
+    for (int j = 1; j < len2 + 1; j++) {
+      // Getting the three candidates for the levenshtein core.
+      xCand.assign(vals[i-1][j].begin(), vals[i-1][j].end());
+      if (xCand.size() < vals[i][j].size()) {
+        xCand.push_back(zeroWire);
+      }
+
+      yCand.assign(vals[i][j-1].begin(), vals[i][j-1].end());
+      if (yCand.size() < vals[i][j].size()) {
+        yCand.push_back(zeroWire);
+      }
+
+      diagCand.assign(vals[i-1][j-1].begin(), vals[i-1][j-1].end());
+      if (diagCand.size() < vals[i][j].size()) {
+        diagCand.push_back(zeroWire);
+      }
+
+      // Uses levenshtein core to get the partial levenshtein value.
+      levenshteinCore(circuit, context, xCand, yCand, diagCand,
+                      in1 + (i - 1) * alphabetBits, in2 + (j - 1) * alphabetBits, vals[i][j], alphabetBits);
+    }
+  }
+
+  // Output the final levenshtein value.
+  std::memcpy(out, vals[len1][len2].data(), vals[len1][len2].size() * sizeof(int));
+}
@@ -1,5 +1,8 @@
+#include <array>
 #include <cstring>
+#include <cstdlib>
 #include <iostream>
+#include <algorithm>
 
 #include "circuit/circuit.h"
 #include "circuit/circuit_utils.h"
@@ -31,7 +34,7 @@ void levenshteinCircuit(garble_circuit *circuit, garble_context *context,
     }
   }
 
-  for (int i = 0; i < len1; i++) {
+  for (int i = 0; i < len1 + 1; i++) {
     for (size_t j = 0; j < vals[i][0].size(); j++) {
       if ((i >> j) % 2 == 0) {
         vals[i][0][j] = zeroWire;
@@ -41,7 +44,7 @@ void levenshteinCircuit(garble_circuit *circuit, garble_context *context,
     }
   }
 
-  for (int i = 0; i < len2; i++) {
+  for (int i = 0; i < len2 + 1; i++) {
     for (size_t j = 0; j < vals[0][i].size(); j++) {
       if ((i >> j) % 2 == 0) {
         vals[0][i][j] = zeroWire;
@@ -81,3 +84,139 @@ void levenshteinCircuit(garble_circuit *circuit, garble_context *context,
   // Output the final levenshtein value.
   std::memcpy(out, vals[len1][len2].data(), vals[len1][len2].size() * sizeof(int));
 }
+
+void levenshteinDiffCircuit(garble_circuit *circuit, garble_context *context,
+                            int *inputs, int *out, int len1, int len2, int alphabetBits) {
+  int *in1 = inputs;
+  int *in2 = inputs + len1 * alphabetBits;
+
+  int zeroWire = wire_zero(circuit);
+  int oneWire = wire_one(circuit);
+
+  // h[j] is the difference between cells j and j - 1 of the current row, as {is 1, is -1}. Row 0 counts up.
+  std::vector<std::array<int, 2> > h(len2 + 1, {{oneWire, zeroWire}});
+  std::vector<int> lastPlus(len1), lastMinus(len1);
+  std::array<int, 2> v, hOut, vOut;
+  int neqWire;
+
+  for (int i = 1; i < len1 + 1; i++) {
+    // v is the difference between the cell in row i and the one above it, which is 1 in column 0.
+    v = {{oneWire, zeroWire}};
+
+    for (int j = 1; j < len2 + 1; j++) {
+      neq(circuit, context, in1 + (i - 1) * alphabetBits, in2 + (j - 1) * alphabetBits, &neqWire, alphabetBits);
+      levenshteinDiffCore(circuit, context, h[j].data(), v.data(), neqWire, hOut.data(), vOut.data());
+      h[j] = hOut;
+      v = vOut;
+    }
+
+    lastPlus[i - 1] = v[0];
+    lastMinus[i - 1] = v[1];
+  }
+
+  // The distance is the top of the last column, len2, plus the differences down that column.
+  int width = ceilLog2(len1 + len2 + 1);
+  std::vector<int> plus(ceilLog2(len1 + 1)), minus(ceilLog2(len1 + 1));
+  std::vector<int> plusWires(width, zeroWire), minusWires(width, zeroWire), lenWires(width), sum(width + 1), dist(width);
+  int sign;
+
+  popcount(circuit, context, lastPlus.data(), plus.data(), len1);
+  popcount(circuit, context, lastMinus.data(), minus.data(), len1);
+
+  for (int b = 0; b < width; b++) {
+    lenWires[b] = ((len2 >> b) % 2 == 0) ? zeroWire : oneWire;
+    if (b < (int) plus.size()) {
+      plusWires[b] = plus[b];
+      minusWires[b] = minus[b];
+    }
+  }
+
+  add(circuit, context, plusWires.data(), lenWires.data(), sum.data(), width);
+  subtract(circuit, context, sum.data(), minusWires.data(), dist.data(), &sign, width);
+
+  std::memcpy(out, dist.data(), (int) ceil(log2(std::max(len1, len2) + 1)) * sizeof(int));
+}
+
+void bandedLevenshteinCircuit(garble_circuit *circuit, garble_context *context,
+                              int *inputs, int *out, int len1, int len2, int alphabetBits, int threshold) {
+  int *in1 = inputs;
+  int *in2 = inputs + len1 * alphabetBits;
+
+  int zeroWire = wire_zero(circuit);
+  int oneWire = wire_one(circuit);
+
+  // Cells hold values up to 2^bits - 1, which is at least threshold + 1.
+  int bits = ceilLog2(threshold + 2);
+
+  auto constant = [&](int value) {
+    std::vector<int> wires(bits);
+    for (int b = 0; b < bits; b++) {
+      wires[b] = ((value >> b) % 2 == 0) ? zeroWire : oneWire;
+    }
+    return wires;
+  };
+
+  if (std::abs(len1 - len2) > threshold) {
+    std::vector<int> result = constant(threshold + 1);
+    std::memcpy(out, result.data(), bits * sizeof(int));
+    return;
+  }
+
+  // Only cells (i, j) with |i - j| <= threshold are built, and band[i][j - i + threshold] holds cell (i, j). Any
+  // cell outside the band has a distance above threshold, and any path to a cell of distance at most threshold
+  // stays inside the band, so treating the cells outside as saturated keeps the distances up to threshold exact.
+  std::vector<std::vector<std::vector<int> > > band(len1 + 1, std::vector<std::vector<int> >(2 * threshold + 1));
+
+  auto inBand = [&](int i, int j) {
+    return i >= 0 && j >= 0 && j <= len2 && std::abs(i - j) <= threshold;
+  };
+
+  std::vector<int> min1Wires(bits), min2Wires(bits), increment(bits, zeroWire), sum(bits + 1);
+  int neqWire, isDiag;
+
+  for (int i = 0; i < len1 + 1; i++) {
+    for (int j = std::max(0, i - threshold); j <= std::min(len2, i + threshold); j++) {
+      std::vector<int> &cell = band[i][j - i + threshold];
+
+      if (i == 0 || j == 0) {
+        cell = constant(i + j);
+        continue;
+      }
+
+      std::vector<int> &diagCand = band[i - 1][j - i + threshold];
+
+      neq(circuit, context, in1 + (i - 1) * alphabetBits, in2 + (j - 1) * alphabetBits, &neqWire, alphabetBits);
+
+      // A saturated candidate can never be the strict minimum, so candidates outside the band are skipped.
+      if (inBand(i - 1, j) || inBand(i, j - 1)) {
+        if (inBand(i - 1, j) && inBand(i, j - 1)) {
+          min(circuit, context, band[i - 1][j - i + threshold + 1].data(), band[i][j - i + threshold - 1].data(),
+              min1Wires.data(), &isDiag, bits);
+        } else if (inBand(i - 1, j)) {
+          min1Wires = band[i - 1][j - i + threshold + 1];
+        } else {
+          min1Wires = band[i][j - i + threshold - 1];
+        }
+
+        min(circuit, context, min1Wires.data(), diagCand.data(), min2Wires.data(), &isDiag, bits);
+        mux(circuit, context, &neqWire, &oneWire, isDiag, increment.data(), 1);
+      } else {
+        min2Wires = diagCand;
+        increment[0] = neqWire;
+      }
+
+      add(circuit, context, min2Wires.data(), increment.data(), sum.data(), bits);
+
+      // Saturate instead of overflowing.
+      cell.resize(bits);
+      for (int b = 0; b < bits; b++) {
+        cell[b] = gateOR(circuit, context, sum[b], sum[bits]);
+      }
+    }
+  }
+
+  // Report every distance above threshold as threshold + 1.
+  std::vector<int> cap = constant(threshold + 1);
+  int capped;
+  min(circuit, context, band[len1][len2 - len1 + threshold].data(), cap.data(), out, &capped, bits);
+}
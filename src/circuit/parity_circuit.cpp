@@ -9,14 +9,11 @@
 void parityCircuit(garble_circuit *circuit, garble_context *context, 
                   int n, int* inputs, int* outputs) {
   int oldInternalWire = wire_zero(circuit);
-  int newInternalWire, productWire;
+  int productWire;
 
   for (int i = 0; i < n; i++) {
-    productWire = builder_next_wire(context);
-    newInternalWire = builder_next_wire(context);
-    gate_AND(circuit, context, inputs[i], inputs[i + n], productWire);
-    gate_XOR(circuit, context, oldInternalWire, productWire, newInternalWire);
-    oldInternalWire=newInternalWire;
+    productWire = gateAND(circuit, context, inputs[i], inputs[i + n]);
+    oldInternalWire = gateXOR(circuit, context, oldInternalWire, productWire);
   }
 
   outputs[0] = oldInternalWire;
@@ -0,0 +1,79 @@
+#include <vector>
+
+#include "circuit/wire_slots.h"
+
+#include "libgarble/garble.h"
+
+// Number of input wires a gate reads.
+static int gateInputs(const garble_gate &gate) {
+  switch (gate.type) {
+    case GARBLE_GATE_ZERO:
+    case GARBLE_GATE_ONE:
+      return 0;
+    case GARBLE_GATE_NOT:
+      return 1;
+    default:
+      return 2;
+  }
+}
+
+void assignWireSlots(const garble_circuit *circuit, WireSlots &wireSlots) {
+  // Index of the last gate reading each wire, or q for output wires, which are read after all gates.
+  std::vector<long> lastUse(circuit->r, -1);
+
+  for (size_t i = 0; i < circuit->q; i++) {
+    const garble_gate &gate = circuit->gates[i];
+    int inputs = gateInputs(gate);
+
+    if (inputs > 0) {
+      lastUse[gate.input0] = i;
+    }
+    if (inputs > 1) {
+      lastUse[gate.input1] = i;
+    }
+  }
+
+  for (size_t i = 0; i < circuit->m; i++) {
+    lastUse[circuit->outputs[i]] = circuit->q;
+  }
+
+  std::vector<int> &slots = wireSlots.slots;
+  std::vector<int> freeSlots;
+  slots.assign(circuit->r, -1);
+
+  for (size_t i = 0; i < circuit->n; i++) {
+    slots[i] = i;
+  }
+  wireSlots.count = circuit->n;
+
+  for (size_t i = 0; i < circuit->n; i++) {
+    if (lastUse[i] < 0) {
+      freeSlots.push_back(slots[i]);
+    }
+  }
+
+  for (size_t i = 0; i < circuit->q; i++) {
+    const garble_gate &gate = circuit->gates[i];
+    int inputs = gateInputs(gate);
+
+    // Inputs are read before the output is written, so a gate may write over an input it was the last to read.
+    if (inputs > 0 && lastUse[gate.input0] == (long) i) {
+      freeSlots.push_back(slots[gate.input0]);
+    }
+    if (inputs > 1 && gate.input1 != gate.input0 && lastUse[gate.input1] == (long) i) {
+      freeSlots.push_back(slots[gate.input1]);
+    }
+
+    if (freeSlots.empty()) {
+      slots[gate.output] = wireSlots.count++;
+    } else {
+      slots[gate.output] = freeSlots.back();
+      freeSlots.pop_back();
+    }
+
+    // Wires that are never read only need their slot while their gate is evaluated.
+    if (lastUse[gate.output] < 0) {
+      freeSlots.push_back(slots[gate.output]);
+    }
+  }
+}
@@ -0,0 +1,269 @@
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+
+#include "libgarble/half_gates.h"
+#include "pke/aesni.h"
+#include "util/random.h"
+
+// Multiplies a block by x in GF(2^128), modulo x^128 + x^7 + x^2 + x + 1.
+static inline block doubleBlock(block x) {
+  block carries = _mm_srli_epi64(x, 63);
+  block overflow = _mm_sub_epi64(_mm_setzero_si128(), _mm_srli_si128(carries, 8));
+  block shifted = _mm_xor_si128(_mm_slli_epi64(x, 1), _mm_slli_si128(carries, 8));
+
+  return _mm_xor_si128(shifted, _mm_and_si128(overflow, _mm_set_epi64x(0, 0x87)));
+}
+
+// Sets keys[i] to H(keys[i], tweaks[i]) = AES(2 * keys[i] ^ tweaks[i]) ^ 2 * keys[i] ^ tweaks[i], under the fixed
+// key with the given round keys, for i < n.
+static inline void hashBlocks(const block *roundKeys, block *keys, const uint64_t *tweaks, size_t n) {
+  block masks[4];
+
+  for (size_t i = 0; i < n; i++) {
+    masks[i] = _mm_xor_si128(doubleBlock(keys[i]), _mm_set_epi64x(0, tweaks[i]));
+    keys[i] = masks[i];
+  }
+
+  aesEncryptBlocksFixedKey(roundKeys, keys, n);
+
+  for (size_t i = 0; i < n; i++) {
+    keys[i] = _mm_xor_si128(keys[i], masks[i]);
+  }
+}
+
+static inline int lsb(block x) {
+  return _mm_cvtsi128_si32(x) & 1;
+}
+
+size_t halfGatesRows(const garble_circuit *topology) {
+  size_t rows = 0;
+
+  for (size_t i = 0; i < topology->q; i++) {
+    if (topology->gates[i].type == GARBLE_GATE_AND || topology->gates[i].type == GARBLE_GATE_OR) {
+      rows++;
+    }
+  }
+
+  return rows;
+}
+
+void halfGatesGarble(const garble_circuit *topology, const WireSlots &wireSlots, std::vector<block> &inputLabels,
+                     GarbledInfo &info, GarbledRowSink &rows) {
+  // Only the label for 0 is kept for each wire, as the label for 1 is always the label for 0 xor delta.
+  const int *slots = wireSlots.slots.data();
+  std::vector<block> labels(wireSlots.count);
+  std::vector<block> random(topology->n + 3);
+
+  threadRandom().fillBlocks(random.data(), random.size());
+
+  // The last bit of delta is set, so the last bits of the two labels of a wire differ and can permute the rows.
+  block delta = _mm_or_si128(random[0], _mm_set_epi64x(0, 1));
+  info.global_key = random[1];
+  info.fixed_label = random[2];
+
+  inputLabels.resize(2 * topology->n);
+  for (size_t i = 0; i < topology->n; i++) {
+    labels[i] = random[i + 3];
+    inputLabels[2 * i] = labels[i];
+    inputLabels[2 * i + 1] = _mm_xor_si128(labels[i], delta);
+  }
+
+  block roundKeys[AESNI_ROUNDS + 1];
+  aesExpandKey128((const unsigned char *) &info.global_key, roundKeys);
+
+  std::vector<block> chunk(std::min(halfGatesRows(topology), (size_t) HALF_GATES_CHUNK_ROWS) * HALF_GATES_ROW_BLOCKS);
+  block *row = chunk.data();
+
+  for (size_t i = 0; i < topology->q; i++) {
+    const garble_gate &gate = topology->gates[i];
+
+    switch (gate.type) {
+      case GARBLE_GATE_ZERO:
+        labels[slots[gate.output]] = info.fixed_label;
+        break;
+      case GARBLE_GATE_ONE:
+        labels[slots[gate.output]] = _mm_xor_si128(info.fixed_label, delta);
+        break;
+      case GARBLE_GATE_XOR:
+        labels[slots[gate.output]] = _mm_xor_si128(labels[slots[gate.input0]], labels[slots[gate.input1]]);
+        break;
+      case GARBLE_GATE_NOT:
+        labels[slots[gate.output]] = _mm_xor_si128(labels[slots[gate.input0]], delta);
+        break;
+      case GARBLE_GATE_AND:
+      case GARBLE_GATE_OR: {
+        // a OR b is NOT(NOT a AND NOT b), so an OR gate is an AND gate with the labels of every wire swapped.
+        block flip = gate.type == GARBLE_GATE_OR ? delta : _mm_setzero_si128();
+        block a0 = _mm_xor_si128(labels[slots[gate.input0]], flip);
+        block b0 = _mm_xor_si128(labels[slots[gate.input1]], flip);
+        int pa = lsb(a0), pb = lsb(b0);
+
+        block h[4] = {a0, _mm_xor_si128(a0, delta), b0, _mm_xor_si128(b0, delta)};
+        uint64_t tweaks[4] = {2 * i, 2 * i, 2 * i + 1, 2 * i + 1};
+        hashBlocks(roundKeys, h, tweaks, 4);
+
+        // Generator half gate.
+        row[0] = _mm_xor_si128(h[0], h[1]);
+        if (pb) {
+          row[0] = _mm_xor_si128(row[0], delta);
+        }
+        block w0 = pa ? _mm_xor_si128(h[0], row[0]) : h[0];
+
+        // Evaluator half gate.
+        block t = _mm_xor_si128(h[2], h[3]);
+        row[1] = _mm_xor_si128(t, a0);
+        w0 = _mm_xor_si128(w0, pb ? _mm_xor_si128(h[2], t) : h[2]);
+
+        labels[slots[gate.output]] = _mm_xor_si128(w0, flip);
+        row += HALF_GATES_ROW_BLOCKS;
+
+        if (row == chunk.data() + chunk.size()) {
+          rows.writeRows(chunk.data(), chunk.size() / HALF_GATES_ROW_BLOCKS);
+          row = chunk.data();
+        }
+        break;
+      }
+      default:
+        throw std::runtime_error("Unsupported gate type for half-gates garbling.");
+    }
+  }
+
+  if (row != chunk.data()) {
+    rows.writeRows(chunk.data(), (row - chunk.data()) / HALF_GATES_ROW_BLOCKS);
+  }
+
+  info.output_perms.resize(topology->m);
+  for (size_t i = 0; i < topology->m; i++) {
+    info.output_perms[i] = lsb(labels[slots[topology->outputs[i]]]);
+  }
+}
+
+void halfGatesGarble(const garble_circuit *topology, std::vector<block> &inputLabels, GarbledInfo &info) {
+  WireSlots wireSlots;
+  assignWireSlots(topology, wireSlots);
+
+  info.table.clear();
+  info.table.reserve(halfGatesRows(topology) * HALF_GATES_ROW_BLOCKS);
+  TableRowSink rows(info.table);
+
+  halfGatesGarble(topology, wireSlots, inputLabels, info, rows);
+}
+
+void TableRowSink::writeRows(const block *rows, size_t count) {
+  table.insert(table.end(), rows, rows + count * HALF_GATES_ROW_BLOCKS);
+}
+
+void StreamRowSink::writeRows(const block *rows, size_t count) {
+  out.write((const char *) rows, count * HALF_GATES_ROW_BLOCKS * sizeof(block));
+}
+
+void halfGatesEval(const garble_circuit *topology, const WireSlots &wireSlots, const block *inputLabels,
+                   const GarbledInfo &info, GarbledRowSource &rows, bool *outputs) {
+  if (info.output_perms.size() != topology->m) {
+    throw std::runtime_error("Garbled output permutation bits do not match the circuit.");
+  }
+
+  // The labels are kept between calls on the same thread, so decrypting many cipher texts does not allocate.
+  static thread_local std::vector<block> labels;
+  const int *slots = wireSlots.slots.data();
+  labels.resize(std::max(labels.size(), wireSlots.count));
+  std::copy(inputLabels, inputLabels + topology->n, labels.begin());
+
+  block roundKeys[AESNI_ROUNDS + 1];
+  aesExpandKey128((const unsigned char *) &info.global_key, roundKeys);
+
+  const block *row = NULL;
+  size_t rowsLeft = 0;
+
+  for (size_t i = 0; i < topology->q; i++) {
+    const garble_gate &gate = topology->gates[i];
+
+    switch (gate.type) {
+      case GARBLE_GATE_ZERO:
+      case GARBLE_GATE_ONE:
+        labels[slots[gate.output]] = info.fixed_label;
+        break;
+      case GARBLE_GATE_XOR:
+        labels[slots[gate.output]] = _mm_xor_si128(labels[slots[gate.input0]], labels[slots[gate.input1]]);
+        break;
+      case GARBLE_GATE_NOT:
+        labels[slots[gate.output]] = labels[slots[gate.input0]];
+        break;
+      case GARBLE_GATE_AND:
+      case GARBLE_GATE_OR: {
+        block a = labels[slots[gate.input0]], b = labels[slots[gate.input1]];
+
+        if (rowsLeft == 0) {
+          row = rows.nextRows(rowsLeft);
+        }
+
+        block h[2] = {a, b};
+        uint64_t tweaks[2] = {2 * i, 2 * i + 1};
+        hashBlocks(roundKeys, h, tweaks, 2);
+
+        block w = lsb(a) ? _mm_xor_si128(h[0], row[0]) : h[0];
+        w = _mm_xor_si128(w, lsb(b) ? _mm_xor_si128(h[1], _mm_xor_si128(row[1], a)) : h[1]);
+
+        labels[slots[gate.output]] = w;
+        row += HALF_GATES_ROW_BLOCKS;
+        rowsLeft--;
+        break;
+      }
+      default:
+        throw std::runtime_error("Unsupported gate type for half-gates evaluation.");
+    }
+  }
+
+  for (size_t i = 0; i < topology->m; i++) {
+    outputs[i] = lsb(labels[slots[topology->outputs[i]]]) != info.output_perms[i];
+  }
+}
+
+// Gives the whole of a table held in memory at once.
+class TableRowSource : public GarbledRowSource {
+ public:
+  TableRowSource(const std::vector<block> &table): table(table), given(false) {};
+
+  virtual const block *nextRows(size_t &count) {
+    if (given || table.size() < HALF_GATES_ROW_BLOCKS) {
+      throw std::runtime_error("Garbled table is too short for the circuit.");
+    }
+
+    given = true;
+    count = table.size() / HALF_GATES_ROW_BLOCKS;
+    return table.data();
+  }
+
+ private:
+  const std::vector<block> &table;
+  bool given;
+};
+
+void halfGatesEval(const garble_circuit *topology, const WireSlots &wireSlots, const block *inputLabels,
+                   const GarbledInfo &info, bool *outputs) {
+  TableRowSource rows(info.table);
+
+  halfGatesEval(topology, wireSlots, inputLabels, info, rows, outputs);
+}
+
+StreamRowSource::StreamRowSource(std::istream &in, uint64_t rows, size_t chunkRows):
+  in(in), rowsLeft(rows), buffer(chunkRows * HALF_GATES_ROW_BLOCKS) {};
+
+const block *StreamRowSource::nextRows(size_t &count) {
+  count = std::min((uint64_t) buffer.size() / HALF_GATES_ROW_BLOCKS, rowsLeft);
+
+  if (count == 0 || !in.read((char *) buffer.data(), count * HALF_GATES_ROW_BLOCKS * sizeof(block))) {
+    throw std::runtime_error("Garbled table is too short for the circuit.");
+  }
+
+  rowsLeft -= count;
+  return buffer.data();
+}
+
+void halfGatesEval(const garble_circuit *topology, const block *inputLabels, const GarbledInfo &info, bool *outputs) {
+  WireSlots wireSlots;
+  assignWireSlots(topology, wireSlots);
+
+  halfGatesEval(topology, wireSlots, inputLabels, info, outputs);
+}
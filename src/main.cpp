@@ -5,6 +5,7 @@
 #include <map>
 #include <stdexcept>
 #include <chrono>
+#include <thread>
 #include <cstdlib>
 
 #include <msgpack.hpp>
@@ -16,7 +17,7 @@
 #include "bounded/stateful.h"
 #include "circuit/circuit.h"
 
-/* This takes as input a text file with a list of options, and then outputs the results of using the specified type of functional encryption scheme to the specified type of circuit, giving the running times for each of Setup, KeyGen, Encrypt, and Decrypt, along with sizes for the MasterPublicKey, MasterSecretKey, SecretKey, and Ciphertext.
+/* This takes as input a text file with a list of options, and then outputs the results of using the specified type of functional encryption scheme to the specified type of circuit, giving the running times for each of Setup, KeyGen, Encrypt, and Decrypt, along with sizes for the MasterPublicKey, MasterSecretKey, SecretKey, and Ciphertext, and gate counts for the circuit.
  */
 
 // Generate a random instance of the given circuit type
@@ -60,6 +61,16 @@ void randomLevenshteinCircuit(Circuit **circuit, int inputLen, int circuitLen, i
   *circuit = new LevenshteinCircuit(circ, inputLen, alphabetBits);
 }
 
+void randomBandedLevenshteinCircuit(Circuit **circuit, int inputLen, int circuitLen, int alphabetBits) {
+  std::vector<int> circ(circuitLen);
+
+  for (size_t i = 0; i < circ.size(); i++) {
+    circ[i] = rand() % (1 << alphabetBits);
+  }
+
+  *circuit = new BandedLevenshteinCircuit(circ, inputLen, alphabetBits);
+}
+
 // give the space required to write an element to file, for keys and ciphertexts
 template <class Writable>
 uint64_t fileSize(Writable w, std::string fileName) {
@@ -73,6 +84,33 @@ uint64_t fileSize(Writable w, std::string fileName) {
   return (uint64_t) size;
 }
 
+// Garbling schemes for One Query FE, by their names in the configuration.
+static const std::map<std::string, GarblingScheme> garblingSchemes = {
+  {"half_gates", GARBLING_SCHEME_HALF_GATES},
+  {"libgarble_standard", GARBLING_SCHEME_LIBGARBLE_STANDARD},
+  {"libgarble_half_gates", GARBLING_SCHEME_LIBGARBLE_HALF_GATES},
+};
+
+// Take an input configuration, and give the garbling scheme for One Query FE
+GarblingScheme handleGarblingOptions(std::map<std::string, std::string> config) {
+  if (config.count("garbling_scheme") == 0) {
+    return GARBLING_SCHEME_HALF_GATES;
+  } else if (garblingSchemes.count(config["garbling_scheme"]) > 0) {
+    return garblingSchemes.at(config["garbling_scheme"]);
+  } else {
+    throw std::runtime_error("Unsupported garbling scheme.");
+  }
+}
+
+// Take an input configuration, and give the number of threads for One Query FE
+int handleThreadOptions(std::map<std::string, std::string> config) {
+  if (config.count("ss_threads") > 0) {
+    return std::stoi(config["ss_threads"]);
+  }
+
+  return 1;
+}
+
 // Take an input configuration, and set up the appropriate circuit description
 void handleCircOptions(CircuitDescription** desc, std::map<std::string, std::string> config) {
   if (config["circuit_type"] == "inner_product_mod_p") {
@@ -90,15 +128,59 @@ void handleCircOptions(CircuitDescription** desc, std::map<std::string, std::str
     int circuitLen = std::stoi(config["circuit_circuit_length"]);
     int bits = std::stoi(config["levenshtein_alphabet_bits"]);
     *desc = new LevenshteinCircuitDescription(inputLen, circuitLen, bits);
+  } else if (config["circuit_type"] == "banded_levenshtein") {
+    int inputLen = std::stoi(config["circuit_input_length"]);
+    int circuitLen = std::stoi(config["circuit_circuit_length"]);
+    int bits = std::stoi(config["levenshtein_alphabet_bits"]);
+    int threshold = std::stoi(config["levenshtein_threshold"]);
+    *desc = new BandedLevenshteinCircuitDescription(inputLen, circuitLen, bits, threshold);
   } else {
     throw std::runtime_error("Unsupported circuit type for One Query FE.");
   }
 }
 
+// Other functional encryption schemes have no garbling pool.
+template <class FE, class MPK>
+void handleGarblingPoolOptions(FE &, const MPK &, std::vector<int>, std::map<std::string, std::string>,
+                               std::ofstream &) {}
+
+// Takes a One Query FE scheme and, if ss_garbling_pool_depth is positive, times filling a garbling pool of that
+// depth with ss_garbling_pool_threads refill threads, then encrypting with a circuit garbled ahead of time
+template <class ES, class MPK>
+void handleGarblingPoolOptions(SS<ES> &fe, const MPK &mpk, std::vector<int> msg,
+                               std::map<std::string, std::string> config, std::ofstream &results) {
+  if (config.count("ss_garbling_pool_depth") == 0 || std::stoul(config["ss_garbling_pool_depth"]) == 0) {
+    return;
+  }
+
+  size_t depth = std::stoul(config["ss_garbling_pool_depth"]);
+  int refillThreads = 1;
+  if (config.count("ss_garbling_pool_threads") > 0) {
+    refillThreads = std::stoi(config["ss_garbling_pool_threads"]);
+  }
+
+  auto t1 = std::chrono::high_resolution_clock::now();
+  fe.StartGarblingPool(mpk, depth, refillThreads);
+  while (fe.GarblingPoolReady() < depth) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  auto t2 = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::milli> ms = t2 - t1;
+  results << "Filling garbling pool took: " << ms.count() << " ms" << std::endl;
+
+  t1 = std::chrono::high_resolution_clock::now();
+  fe.Encrypt(msg);
+  t2 = std::chrono::high_resolution_clock::now();
+  ms = t2 - t1;
+  results << "Encryption from garbling pool took: " << ms.count() << " ms" << std::endl;
+
+  fe.StopGarblingPool();
+}
+
 // Takes a functional encryption scheme, and tests it to get running times and
-// key and ciphertext sizes
+// key and ciphertext sizes, along with gate counts for its circuit description
 template <class FE>
-void handleFEOptions(FE fe, std::map<std::string, std::string> config) {
+void handleFEOptions(FE fe, std::map<std::string, std::string> config, CircuitDescription *desc) {
   std::ofstream results;
   results.open(config["results_file_name"]);
 
@@ -120,6 +202,8 @@ void handleFEOptions(FE fe, std::map<std::string, std::string> config) {
     randomHammingCircuit(&circuit, std::stoi(config["circuit_input_length"]));
   } else if (config["circuit_type"] == "levenshtein") {
     randomLevenshteinCircuit(&circuit, std::stoi(config["circuit_input_length"]), std::stoi(config["circuit_circuit_length"]), std::stoi(config["levenshtein_alphabet_bits"]));
+  } else if (config["circuit_type"] == "banded_levenshtein") {
+    randomBandedLevenshteinCircuit(&circuit, std::stoi(config["circuit_input_length"]), std::stoi(config["circuit_circuit_length"]), std::stoi(config["levenshtein_alphabet_bits"]));
   } else {
     throw std::runtime_error("Unrecognized circuit type.");
   }
@@ -148,7 +232,7 @@ void handleFEOptions(FE fe, std::map<std::string, std::string> config) {
     for (size_t i = 0; i < msg.size(); i++) {
       msg[i] = rand() % 2;
     }
-  } else if (config["circuit_type"] == "levenshtein") {
+  } else if (config["circuit_type"] == "levenshtein" || config["circuit_type"] == "banded_levenshtein") {
     msg.resize(((LevenshteinCircuit *) circuit)->inputLen);
     for (size_t i = 0; i < msg.size(); i++) {
       msg[i] = rand() % (1 << ((LevenshteinCircuit *) circuit)->alphabetBits);
@@ -164,12 +248,21 @@ void handleFEOptions(FE fe, std::map<std::string, std::string> config) {
   results << "Encryption took: " << ms.count() << " ms" << std::endl;
   results << "CipherText size: " << fileSize(ct, config["cipher_text_file_name"]) << std::endl;
 
+  handleGarblingPoolOptions(fe, p.pk, msg, config, results);
+
   t1 = std::chrono::high_resolution_clock::now();
   fe.Decrypt(sk, ct);
   t2 = std::chrono::high_resolution_clock::now();
   ms = t2 - t1;
   results << "Decryption took: " << ms.count() << " ms" << std::endl;
 
+  results << desc->statistics();
+
+  for (auto &scheme: garblingSchemes) {
+    results << "Garbled table blocks (" << scheme.first << "): "
+            << garbledTableBlocks(desc->universalCircuitTopology(), scheme.second) << std::endl;
+  }
+
   results.close();
 }
 
@@ -231,6 +324,10 @@ int main(int argc, char *argv[]) {
       RSA rsa;
       
       handleESOptions(rsa, config);
+    } else if (config["base_encryption_scheme"] == "ECC") {
+      ECC ecc;
+
+      handleESOptions(ecc, config);
     } else {
       AES aes;
 
@@ -241,45 +338,68 @@ int main(int argc, char *argv[]) {
 
     handleCircOptions(&desc, config);
 
+    int threads = handleThreadOptions(config);
+    GarblingScheme scheme = handleGarblingOptions(config);
+    bool seededKeys = (config["seeded_master_keys"] == "yes");
+
     if (config["base_encryption_scheme"] == "singleton_RSA") {
-      SS_SingletonRSA fe(desc);
+      SS_SingletonRSA fe(desc, threads, scheme, seededKeys);
 
-      handleFEOptions(fe, config);
+      handleFEOptions(fe, config, desc);
     } else if (config["base_encryption_scheme"] == "singleton_AES") {
-      SS_SingletonAES fe(desc);
+      SS_SingletonAES fe(desc, threads, scheme, seededKeys);
 
-      handleFEOptions(fe, config);
+      handleFEOptions(fe, config, desc);
     } else if (config["base_encryption_scheme"] == "RSA") {
-      SS_RSA fe(desc);
+      SS_RSA fe(desc, threads, scheme, seededKeys);
+
+      handleFEOptions(fe, config, desc);
+    } else if (config["base_encryption_scheme"] == "singleton_ECC") {
+      SS_SingletonECC fe(desc, threads, scheme, seededKeys);
 
-      handleFEOptions(fe, config);
+      handleFEOptions(fe, config, desc);
+    } else if (config["base_encryption_scheme"] == "ECC") {
+      SS_ECC fe(desc, threads, scheme, seededKeys);
+
+      handleFEOptions(fe, config, desc);
     } else {
-      SS_AES fe(desc);
+      SS_AES fe(desc, threads, scheme, seededKeys);
 
-      handleFEOptions(fe, config);
+      handleFEOptions(fe, config, desc);
     }
   } else if (config["encryption_scheme_type"] == "stateful") {
     CircuitDescription *desc;
     handleCircOptions(&desc, config);
 
     int keys = std::stoi(config["bounded_collusion_function_limit"]);
+    int threads = handleThreadOptions(config);
+    GarblingScheme scheme = handleGarblingOptions(config);
+    bool seededKeys = (config["seeded_master_keys"] == "yes");
 
     if (config["base_encryption_scheme"] == "singleton_RSA") {
-      StatefulFE_SingletonRSA fe(keys, desc);
+      StatefulFE_SingletonRSA fe(keys, desc, threads, scheme, seededKeys);
 
-      handleFEOptions(fe, config);
+      handleFEOptions(fe, config, desc);
     } else if (config["base_encryption_scheme"] == "singleton_AES") {
-      StatefulFE_SingletonAES fe(keys, desc);
+      StatefulFE_SingletonAES fe(keys, desc, threads, scheme, seededKeys);
 
-      handleFEOptions(fe, config);
+      handleFEOptions(fe, config, desc);
     } else if (config["base_encryption_scheme"] == "RSA") {
-      StatefulFE_RSA fe(keys, desc);
+      StatefulFE_RSA fe(keys, desc, threads, scheme, seededKeys);
+
+      handleFEOptions(fe, config, desc);
+    } else if (config["base_encryption_scheme"] == "singleton_ECC") {
+      StatefulFE_SingletonECC fe(keys, desc, threads, scheme, seededKeys);
+
+      handleFEOptions(fe, config, desc);
+    } else if (config["base_encryption_scheme"] == "ECC") {
+      StatefulFE_ECC fe(keys, desc, threads, scheme, seededKeys);
 
-      handleFEOptions(fe, config);
+      handleFEOptions(fe, config, desc);
     } else {
-      StatefulFE_AES fe(keys, desc);
+      StatefulFE_AES fe(keys, desc, threads, scheme, seededKeys);
 
-      handleFEOptions(fe, config);
+      handleFEOptions(fe, config, desc);
     }
   } else {
     int keys = std::stoi(config["bounded_collusion_function_limit"]);
@@ -289,6 +409,9 @@ int main(int argc, char *argv[]) {
     int delta_size = std::stoi(config["gvw_delta_size"]);
     int delta_pool_size = std::stoi(config["gvw_delta_pool_size"]);
     bool useDelta = (config["gvw_use_delta"] == "yes");
+    int threads = handleThreadOptions(config);
+    GarblingScheme scheme = handleGarblingOptions(config);
+    bool seededKeys = (config["seeded_master_keys"] == "yes");
     int modulus = std::stoi(config["circuit_modulus"]);
     CircuitDescription *desc;
 
@@ -301,21 +424,29 @@ int main(int argc, char *argv[]) {
     }
 
     if (config["base_encryption_scheme"] == "singleton_RSA") {
-      GVW_SS_SingletonRSA fe(keys, depth, secret_shares, total_shares, delta_size, delta_pool_size, modulus, useDelta, desc);
+      GVW_SS_SingletonRSA fe(keys, depth, secret_shares, total_shares, delta_size, delta_pool_size, modulus, useDelta, desc, threads, scheme, seededKeys);
 
-      handleFEOptions(fe, config);
+      handleFEOptions(fe, config, fe.oneQueryCircuitDescription());
     } else if (config["base_encryption_scheme"] == "singleton_AES") {
-      GVW_SS_SingletonAES fe(keys, depth, secret_shares, total_shares, delta_size, delta_pool_size, modulus, useDelta, desc);
+      GVW_SS_SingletonAES fe(keys, depth, secret_shares, total_shares, delta_size, delta_pool_size, modulus, useDelta, desc, threads, scheme, seededKeys);
 
-      handleFEOptions(fe, config);
+      handleFEOptions(fe, config, fe.oneQueryCircuitDescription());
     } else if (config["base_encryption_scheme"] == "RSA") {
-      GVW_SS_RSA fe(keys, depth, secret_shares, total_shares, delta_size, delta_pool_size, modulus, useDelta, desc);
+      GVW_SS_RSA fe(keys, depth, secret_shares, total_shares, delta_size, delta_pool_size, modulus, useDelta, desc, threads, scheme, seededKeys);
+
+      handleFEOptions(fe, config, fe.oneQueryCircuitDescription());
+    } else if (config["base_encryption_scheme"] == "singleton_ECC") {
+      GVW_SS_SingletonECC fe(keys, depth, secret_shares, total_shares, delta_size, delta_pool_size, modulus, useDelta, desc, threads, scheme, seededKeys);
+
+      handleFEOptions(fe, config, fe.oneQueryCircuitDescription());
+    } else if (config["base_encryption_scheme"] == "ECC") {
+      GVW_SS_ECC fe(keys, depth, secret_shares, total_shares, delta_size, delta_pool_size, modulus, useDelta, desc, threads, scheme, seededKeys);
 
-      handleFEOptions(fe, config);
+      handleFEOptions(fe, config, fe.oneQueryCircuitDescription());
     } else {
-      GVW_SS_AES fe(keys, depth, secret_shares, total_shares, delta_size, delta_pool_size, modulus, useDelta, desc);
+      GVW_SS_AES fe(keys, depth, secret_shares, total_shares, delta_size, delta_pool_size, modulus, useDelta, desc, threads, scheme, seededKeys);
 
-      handleFEOptions(fe, config);
+      handleFEOptions(fe, config, fe.oneQueryCircuitDescription());
     }
   }
 }
@@ -10,18 +10,39 @@
 #include "oneqfe/singleton.h"
 #include "oneqfe/esWrapper.h"
 #include "circuit/circuit.h"
+#include "util/parallel.h"
+#include "util/random.h"
+#include "file/writable.h"
 
 #include "libgarble/garble.h"
 #include "libgarble/circuit_builder.h"
+#include "libgarble/half_gates.h"
 
 template<class ES>
-SS<ES>::SS(CircuitDescription *description) {
+SS<ES>::SS(CircuitDescription *description, int threads, GarblingScheme scheme, bool seededKeys) {
   circuitDescription = description;
+  this->threads = threads;
+  this->scheme = scheme;
+  this->seededKeys = seededKeys;
 }
 
 template<class ES>
 typename SS<ES>::KeyPair SS<ES>::Setup(int length) {
   typename SS<ES>::KeyPair p;
+
+  if (seededKeys) {
+    p.sk.seed.resize(16);
+    threadRandom().GenerateBlock(p.sk.seed.data(), p.sk.seed.size());
+
+    // Throws now, rather than in KeyGen or Encrypt, if ES cannot derive keys.
+    ES::Derive(p.sk.seed, length, 0);
+
+    p.sk.keyLength = length;
+    p.pk.seed = p.sk.seed;
+    p.pk.keyLength = length;
+    return p;
+  }
+
   p.sk = typename SS<ES>::MasterSecretKey(circuitDescription->circuit_size);
   p.pk = typename SS<ES>::MasterPublicKey(circuitDescription->circuit_size);
 
@@ -47,8 +68,22 @@ typename SS<ES>::SecretKey SS<ES>::KeyGen(typename SS<ES>::MasterSecretKey msk,
 
   for (int i=0; i<circuitDescription->circuit_size; i++) {
     sk.bits[i] = circuit->getBit(i);
+  }
 
-    if (sk.bits[i] == 0) {
+  // Seeded keys for the chosen bits are derived in one batch.
+  std::vector<typename ES::KeyPair> derived;
+  if (!msk.seed.empty()) {
+    std::vector<uint64_t> indices(circuitDescription->circuit_size);
+    for (size_t i = 0; i < indices.size(); i++) {
+      indices[i] = 2 * (uint64_t) i + sk.bits[i];
+    }
+    ES::DeriveBatch(msk.seed, msk.keyLength, indices.data(), indices.size(), derived);
+  }
+
+  for (int i=0; i<circuitDescription->circuit_size; i++) {
+    if (!msk.seed.empty()) {
+      sk.sks[i] = ES::KeyGen(derived[i].sk);
+    } else if (sk.bits[i] == 0) {
       sk.sks[i] = ES::KeyGen(msk.sks[i].first);
     } else {
       sk.sks[i] = ES::KeyGen(msk.sks[i].second);
@@ -60,90 +95,500 @@ typename SS<ES>::SecretKey SS<ES>::KeyGen(typename SS<ES>::MasterSecretKey msk,
 template<class ES>
 typename SS<ES>::CipherText SS<ES>::Encrypt(typename SS<ES>::MasterPublicKey mpk, std::vector<int> msg) {
 
+  typename SS<ES>::CipherText ct;
+  std::vector<block> inputLabels;
+
+  garble(mpk, inputLabels, ct);
+  setMessageLabels(msg, inputLabels, ct);
+
+  return ct;
+}
+
+template<class ES>
+void SS<ES>::garble(const typename SS<ES>::MasterPublicKey &mpk, std::vector<block> &inputLabels,
+                    typename SS<ES>::CipherText &ct) {
+  if (scheme != GARBLING_SCHEME_HALF_GATES) {
+    garbleWithLibgarble(inputLabels, ct.garbled_info);
+  } else {
+    // Garble the cached universal circuit in its cached wire slots, writing the table rows straight into the cipher
+    // text.
+    const garble_circuit *circuit = circuitDescription->universalCircuitTopology();
+    ct.garbled_info.version = GARBLED_INFO_VERSION_COMPACT;
+    ct.garbled_info.table.reserve(halfGatesRows(circuit) * HALF_GATES_ROW_BLOCKS);
+    TableRowSink rows(ct.garbled_info.table);
+    halfGatesGarble(circuit, circuitDescription->universalCircuitWireSlots(), inputLabels, ct.garbled_info, rows);
+  }
+
+  encryptInputs(mpk, inputLabels, ct);
+}
+
+template<class ES>
+void SS<ES>::garbleWithLibgarble(std::vector<block> &inputLabels, GarbledInfo &info) {
   garble_circuit circuit;
 
-  // get the universal circuit, and garble it
+  // get a copy of the cached universal circuit, and garble it with the libgarble type of the scheme
   circuitDescription->universalCircuit(&circuit);
+  circuit.type = libgarbleType(scheme);
   garble_garble(&circuit, NULL, NULL);
 
-  typename SS<ES>::CipherText ct;
+  info.version = GARBLED_INFO_VERSION_LIBGARBLE_TYPED;
+  info.garbleType = circuit.type;
+  info.output_perms.assign(circuit.output_perms, circuit.output_perms + circuit.m);
+  info.packTable(&circuit);
+  info.fixed_label = circuit.fixed_label;
+  info.global_key = circuit.global_key;
 
-  ct.garbled_info.output_perms.resize(circuit.m);
-  
-  for (size_t i = 0; i < circuit.m; i++) {
-    ct.garbled_info.output_perms[i] = circuit.output_perms[i];
-  }
+  inputLabels.assign(circuit.wires, circuit.wires + 2 * circuit.n);
 
-  ct.garbled_info.table.resize(circuit.q);
-  ct.garbled_info.packTable(&circuit);
-  ct.garbled_info.fixed_label = circuit.fixed_label;
-  ct.garbled_info.global_key = circuit.global_key;
+  garble_delete(&circuit);
+}
 
+template<class ES>
+void SS<ES>::setMessageLabels(std::vector<int> &msg, const std::vector<block> &inputLabels,
+                              typename SS<ES>::CipherText &ct) {
   ct.labels.resize(circuitDescription->input_size);
-  ct.inputs.resize(circuitDescription->circuit_size);
 
   //use only the encoded labels for the message
   for (int i = 0; i < circuitDescription->input_size; i++) {
-    ct.labels[i] = circuit.wires[2 * i + circuitDescription->msgBit(msg, i)];
+    ct.labels[i] = inputLabels[2 * i + circuitDescription->msgBit(msg, i)];
+  }
+}
+
+template<class ES>
+void SS<ES>::encryptInputs(const typename SS<ES>::MasterPublicKey &mpk, const std::vector<block> &inputLabels,
+                           typename SS<ES>::CipherText &ct) {
+  ct.inputs.resize(circuitDescription->circuit_size);
+
+  //if input bit i is b, encrypt it with msk[i][b], as one batch per thread
+  parallelFor(threads, circuitDescription->circuit_size, [&](size_t begin, size_t end) {
+    size_t count = 2 * (end - begin);
+    std::vector<const typename ES::MasterPublicKey *> pks(count);
+    std::vector<typename ES::PlainText> pts(count);
+    std::vector<typename ES::CipherText> cts(count);
+
+    // Seeded keys are only derived for this batch, from a single expansion of the seed.
+    std::vector<typename ES::KeyPair> derived;
+    if (!mpk.seed.empty()) {
+      std::vector<uint64_t> indices(count);
+      for (size_t i = 0; i < count; i++) {
+        indices[i] = 2 * begin + i;
+      }
+      ES::DeriveBatch(mpk.seed, mpk.keyLength, indices.data(), count, derived);
+    }
+
+    for (size_t i = begin; i < end; i++) {
+      const unsigned char *bytes1 = (const unsigned char*) &inputLabels[2 * i + 2 * circuitDescription->input_size];
+      const unsigned char *bytes2 = (const unsigned char*) &inputLabels[2 * i + 1 + 2 * circuitDescription->input_size];
+      if (!mpk.seed.empty()) {
+        pks[2 * (i - begin)] = &derived[2 * (i - begin)].pk;
+        pks[2 * (i - begin) + 1] = &derived[2 * (i - begin) + 1].pk;
+      } else {
+        pks[2 * (i - begin)] = &mpk.pks[i].first;
+        pks[2 * (i - begin) + 1] = &mpk.pks[i].second;
+      }
+      pts[2 * (i - begin)] = typename ES::PlainText(bytes1, bytes1 + 16);
+      pts[2 * (i - begin) + 1] = typename ES::PlainText(bytes2, bytes2 + 16);
+    }
+
+    ES::EncryptBatch(pks.data(), pts.data(), cts.data(), count);
+
+    for (size_t i = begin; i < end; i++) {
+      ct.inputs[i].first = cts[2 * (i - begin)];
+      ct.inputs[i].second = cts[2 * (i - begin) + 1];
+    }
+  });
+}
+
+template<class ES>
+void SS<ES>::Encrypt(typename SS<ES>::MasterPublicKey mpk, std::vector<int> msg, std::ostream &out) {
+  // Only halfGatesGarble writes rows as it goes.
+  if (scheme != GARBLING_SCHEME_HALF_GATES) {
+    msgpack::pack(out, Encrypt(mpk, msg));
+    return;
   }
 
-  //if input bit i is b, encrypt it with msk[i][b]
-  for (int i = 0; i < circuitDescription->circuit_size; i++) {
-    const unsigned char *bytes1 = (const unsigned char*) &circuit.wires[2 * i + 2 * circuitDescription->input_size];
-    typename ES::PlainText pt1(bytes1, bytes1 + 16);
-    const unsigned char *bytes2 = (const unsigned char*) &circuit.wires[2 * i + 1 + 2 * circuitDescription->input_size];
-    typename ES::PlainText pt2(bytes2, bytes2 + 16);
-    ct.inputs[i].first = ES::Encrypt(mpk.pks[i].first, pt1);
-    ct.inputs[i].second = ES::Encrypt(mpk.pks[i].second, pt2);
+  // Nothing is written to a stream that can not be sought back in.
+  if (out.tellp() == std::streampos(-1)) {
+    throw std::runtime_error("Cipher texts can only be streamed to a seekable stream.");
   }
 
-  return ct;
+  const garble_circuit *circuit = circuitDescription->universalCircuitTopology();
+  uint64_t tableSize = halfGatesRows(circuit) * HALF_GATES_ROW_BLOCKS;
+
+  typename SS<ES>::CipherText ct;
+  ct.garbled_info.version = GARBLED_INFO_VERSION_COMPACT;
+  ct.garbled_info.output_perms.resize(circuit->m);
+  std::vector<char> prefix = ct.garbled_info.compactPrefix(tableSize);
+
+  msgpack::packer<std::ostream> pk(out);
+  pk.pack_array(3);
+  pk.pack_bin(prefix.size() + tableSize * sizeof(block));
+
+  // The keys and output permutation bits are only known once the circuit is garbled, so leave space for them.
+  std::streampos prefixPosition = out.tellp();
+  pk.pack_bin_body(prefix.data(), prefix.size());
+
+  std::vector<block> inputLabels;
+  StreamRowSink rows(out);
+  halfGatesGarble(circuit, circuitDescription->universalCircuitWireSlots(), inputLabels, ct.garbled_info, rows);
+
+  encryptInputs(mpk, inputLabels, ct);
+  setMessageLabels(msg, inputLabels, ct);
+  ct.packLabelsAndInputs(pk);
+
+  std::streampos end = out.tellp();
+  prefix = ct.garbled_info.compactPrefix(tableSize);
+  out.seekp(prefixPosition);
+  out.write(prefix.data(), prefix.size());
+  out.seekp(end);
 }
 
 template<class ES>
-std::vector<int> SS<ES>::Decrypt(typename SS<ES>::SecretKey sk, typename SS<ES>::CipherText ct) {
-  garble_circuit circuit;
+void SS<ES>::StartGarblingPool(typename SS<ES>::MasterPublicKey mpk, size_t depth, int refillThreads) {
+  // The cached circuit is built before the threads start, rather than by the first of them.
+  circuitDescription->universalCircuitWireSlots();
+
+  // The threads all garble with one copy of this scheme without the pool, which garble only reads, so the pool does
+  // not hold a reference to itself.
+  SS<ES> garbler(circuitDescription, threads, scheme, seededKeys);
+
+  garblingPool.reset();
+  garblingPool = std::make_shared<RefillPool<Garbling> >(depth, refillThreads, [garbler, mpk](Garbling &garbling) mutable {
+    garbler.garble(mpk, garbling.messageLabels, garbling.ct);
+
+    // Only the labels of the message inputs are needed later.
+    garbling.messageLabels.resize(2 * garbler.circuitDescription->input_size);
+    garbling.messageLabels.shrink_to_fit();
+  });
+}
 
-  // generate the universal circuit
-  circuitDescription->universalCircuit(&circuit);
+template<class ES>
+void SS<ES>::StopGarblingPool() {
+  garblingPool.reset();
+}
 
-  std::vector<block> extractedLabels(circuit.n);
+template<class ES>
+size_t SS<ES>::GarblingPoolReady() {
+  if (!garblingPool) {
+    return 0;
+  }
+
+  return garblingPool->ready();
+}
+
+template<class ES>
+typename SS<ES>::CipherText SS<ES>::Encrypt(std::vector<int> msg) {
+  if (!garblingPool) {
+    throw std::runtime_error("Encrypting without a key needs a garbling pool.");
+  }
+
+  Garbling garbling = garblingPool->take();
+  setMessageLabels(msg, garbling.messageLabels, garbling.ct);
+
+  return std::move(garbling.ct);
+}
+
+// Checks that a cipher text with the given numbers of labels and encrypted labels has one for every input of circuit,
+// and that sk has a key for each of its encrypted labels.
+template<class SecretKey>
+static void checkCipherTextSize(const SecretKey &sk, size_t labels, size_t inputs, const garble_circuit *circuit) {
+  if (labels + inputs != circuit->n) {
+    throw msgpack::type_error();
+  }
+  if (sk.bits.size() != inputs || sk.sks.size() != inputs) {
+    throw std::runtime_error("The secret key does not fit the cipher text.");
+  }
+}
+
+template<class ES>
+std::vector<int> SS<ES>::Decrypt(const typename SS<ES>::SecretKey &sk, const typename SS<ES>::CipherText &ct) {
+  const garble_circuit *circuit = topologyOf(ct.garbled_info);
+  checkCipherTextSize(sk, ct.labels.size(), ct.inputs.size(), circuit);
+
+  std::vector<block> extractedLabels(circuit->n);
 
   // copy the labels for the message
   memcpy(extractedLabels.data(), ct.labels.data(), ct.labels.size() * sizeof(block));
 
   //decrypt the labels given by the secret key
-  std::vector<unsigned char> bytes;
-  for (size_t i = 0; i < ct.inputs.size(); i++) {
-    if (sk.bits[i] == 0) {
-      bytes = ES::Decrypt(sk.sks[i], ct.inputs[i].first);
-    } else {
-      bytes = ES::Decrypt(sk.sks[i], ct.inputs[i].second);
-    }
-    extractedLabels[i + ct.labels.size()] = _mm_loadu_si128((__m128i *) bytes.data());
+  const typename SS<ES>::CipherText *cts = &ct;
+  parallelFor(threads, ct.inputs.size(), [&](size_t begin, size_t end) {
+    decryptLabels(sk, &cts, 1, begin, end, extractedLabels.data());
+  });
+
+  // Evaluate the garbled circuit.
+  bool vals[circuit->m];
+  evaluate(ct, extractedLabels.data(), vals);
+
+  return circuitDescription->returnVals(vals);
+}
+
+// Reads the header of the msgpack array or bin next in in, setting its type and giving its size.
+static uint32_t readMsgpackHeader(std::istream &in, msgpack::type::object_type &type) {
+  unsigned char c = in.get();
+  int bytes;
+
+  if ((c & 0xf0) == 0x90) {
+    type = msgpack::type::ARRAY;
+    return c & 0x0f;
+  } else if (c == 0xdc || c == 0xdd) {
+    type = msgpack::type::ARRAY;
+    bytes = c == 0xdc ? 2 : 4;
+  } else if (c == 0xc4 || c == 0xc5 || c == 0xc6) {
+    type = msgpack::type::BIN;
+    bytes = 1 << (c - 0xc4);
+  } else {
+    throw msgpack::type_error();
+  }
+
+  uint32_t size = 0;
+  for (int i = 0; i < bytes; i++) {
+    size = (size << 8) | (unsigned char) in.get();
+  }
+
+  if (!in) {
+    throw msgpack::type_error();
   }
+  return size;
+}
 
-  // Unpack garbled_info into circuit to evaulate it
-  circuit.output_perms = (bool *) calloc(circuit.m, sizeof(bool));
-  
-  for (size_t i = 0; i < circuit.m; i ++) {
-    circuit.output_perms[i] = ct.garbled_info.output_perms[i];
+template<class ES>
+std::vector<int> SS<ES>::DecryptFromFile(const typename SS<ES>::SecretKey &sk, std::string fileName) {
+  std::ifstream file;
+  file.open(fileName, std::ios::in | std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("Could not open cipher text file " + fileName + ".");
   }
 
-  ct.garbled_info.unpackTable(&circuit);
+  msgpack::type::object_type type;
+  if (readMsgpackHeader(file, type) != 3 || type != msgpack::type::ARRAY) {
+    throw msgpack::type_error();
+  }
 
-  circuit.fixed_label=ct.garbled_info.fixed_label;
-  circuit.global_key=ct.garbled_info.global_key;
+  // Only the compact encoding says how long the table is before it, so older cipher texts are read whole.
+  uint32_t infoSize = readMsgpackHeader(file, type);
+  if (type != msgpack::type::BIN) {
+    file.close();
 
-  // Evaluate the garbled circuit.
-  bool vals[circuit.m];
-  garble_eval(&circuit, extractedLabels.data(), NULL, vals);
+    typename SS<ES>::CipherText ct;
+    readFromFile(ct, fileName);
+    return Decrypt(sk, ct);
+  }
+
+  std::vector<char> prefix(GARBLED_INFO_COMPACT_HEADER_SIZE);
+  file.read(prefix.data(), prefix.size());
+  if (!file || infoSize < GarbledInfo::compactPrefixSize(prefix.data())) {
+    throw msgpack::type_error();
+  }
+
+  prefix.resize(GarbledInfo::compactPrefixSize(prefix.data()));
+  file.read(prefix.data() + GARBLED_INFO_COMPACT_HEADER_SIZE, prefix.size() - GARBLED_INFO_COMPACT_HEADER_SIZE);
+
+  GarbledInfo info;
+  uint64_t tableSize = info.unpackCompactPrefix(prefix.data());
+  if (!file || infoSize != prefix.size() + tableSize * sizeof(block)) {
+    throw msgpack::type_error();
+  }
+
+  // Skip the table for now, to read the labels and encrypted inputs after it.
+  std::streampos table = file.tellg();
+  file.seekg(0, std::ios::end);
+  std::streampos end = file.tellg();
+  if ((uint64_t) (end - table) / sizeof(block) < tableSize) {
+    throw msgpack::type_error();
+  }
+  file.seekg(table + (std::streamoff) (tableSize * sizeof(block)));
+
+  std::vector<char> rest(end - file.tellg());
+  file.read(rest.data(), rest.size());
+
+  size_t offset = 0;
+  msgpack::object_handle labelsHandle = msgpack::unpack(rest.data(), rest.size(), offset);
+  msgpack::object_handle inputsHandle = msgpack::unpack(rest.data(), rest.size(), offset);
+  msgpack::object labels = labelsHandle.get(), inputs = inputsHandle.get();
+
+  const garble_circuit *circuit = circuitDescription->universalCircuitTopology();
+  if (labels.type != msgpack::type::BIN || inputs.type != msgpack::type::ARRAY ||
+      labels.via.bin.size % sizeof(block) != 0 || inputs.via.array.size % 2 != 0) {
+    throw msgpack::type_error();
+  }
+
+  size_t labelCount = labels.via.bin.size / sizeof(block), inputCount = inputs.via.array.size / 2;
+  checkCipherTextSize(sk, labelCount, inputCount, circuit);
+
+  std::vector<block> extractedLabels(circuit->n);
+  memcpy(extractedLabels.data(), labels.via.bin.ptr, labelCount * sizeof(block));
+
+  //decrypt only the labels given by the secret key, as one batch in ES on each thread, as in decryptLabels
+  parallelFor(threads, inputCount, [&](size_t begin, size_t end) {
+    std::vector<typename ES::CipherText> chosen(end - begin);
+    std::vector<const typename ES::SecretKey *> sks(end - begin);
+    std::vector<const typename ES::CipherText *> cts(end - begin);
+    std::vector<typename ES::PlainText> pts(end - begin);
+
+    for (size_t i = begin; i < end; i++) {
+      chosen[i - begin].msgpack_unpack(inputs.via.array.ptr[2 * i + (sk.bits[i] == 0 ? 0 : 1)]);
+      sks[i - begin] = &sk.sks[i];
+      cts[i - begin] = &chosen[i - begin];
+    }
+
+    ES::DecryptBatch(sks.data(), cts.data(), pts.data(), end - begin);
+
+    for (size_t i = begin; i < end; i++) {
+      extractedLabels[i + labelCount] = _mm_loadu_si128((__m128i *) pts[i - begin].data());
+    }
+  });
+
+  file.clear();
+  file.seekg(table);
+  StreamRowSource rows(file, tableSize / HALF_GATES_ROW_BLOCKS);
+
+  bool vals[circuit->m];
+  halfGatesEval(circuit, circuitDescription->universalCircuitWireSlots(), extractedLabels.data(), info, rows, vals);
 
   return circuitDescription->returnVals(vals);
 }
 
+template<class ES>
+const garble_circuit *SS<ES>::topologyOf(const GarbledInfo &info) {
+  if (info.version == GARBLED_INFO_VERSION_LIBGARBLE) {
+    return circuitDescription->legacyUniversalCircuitTopology();
+  }
+
+  return circuitDescription->universalCircuitTopology();
+}
+
+template<class ES>
+void SS<ES>::evaluate(const typename SS<ES>::CipherText &ct, const block *labels, bool *vals) {
+  // Evaluate straight from the compact table, with the cached wire slots.
+  if (!ct.garbled_info.libgarbleTable()) {
+    halfGatesEval(circuitDescription->universalCircuitTopology(), circuitDescription->universalCircuitWireSlots(),
+                  labels, ct.garbled_info, vals);
+    return;
+  }
+
+  // Other cipher texts hold libgarble tables, so unpack garbled_info into a copy of the topology to evaulate it.
+  garble_circuit circuit = *topologyOf(ct.garbled_info);
+  ct.garbled_info.attachLibgarbleTable(&circuit);
+
+  garble_eval(&circuit, labels, NULL, vals);
+
+  free(circuit.output_perms);
+  free(circuit.table);
+}
+
+template<class ES>
+void SS<ES>::decryptLabels(const typename SS<ES>::SecretKey &sk, const typename SS<ES>::CipherText *const *cts,
+                           size_t count, size_t begin, size_t end, block *labels) {
+  size_t n = (end - begin) * count, stride = circuitDescription->universalCircuitTopology()->n;
+  std::vector<const typename ES::SecretKey *> sks(n);
+  std::vector<const typename ES::CipherText *> inputs(n);
+  std::vector<typename ES::PlainText> pts(n);
+
+  for (size_t i = begin; i < end; i++) {
+    for (size_t j = 0; j < count; j++) {
+      sks[(i - begin) * count + j] = &sk.sks[i];
+      inputs[(i - begin) * count + j] = sk.bits[i] == 0 ? &cts[j]->inputs[i].first : &cts[j]->inputs[i].second;
+    }
+  }
+
+  ES::DecryptBatch(sks.data(), inputs.data(), pts.data(), n);
+
+  for (size_t i = begin; i < end; i++) {
+    for (size_t j = 0; j < count; j++) {
+      const typename ES::PlainText &pt = pts[(i - begin) * count + j];
+      labels[j * stride + cts[j]->labels.size() + i] = _mm_loadu_si128((__m128i *) pt.data());
+    }
+  }
+}
+
+template<class ES>
+std::vector<std::vector<int> > SS<ES>::DecryptBatch(const typename SS<ES>::SecretKey &sk,
+                                                    const std::vector<typename SS<ES>::CipherText> &cts) {
+  // Every topology has the same inputs and outputs, whichever table the cipher text holds.
+  const garble_circuit *circuit = circuitDescription->universalCircuitTopology();
+  std::vector<std::vector<int> > results(cts.size());
+
+  for (size_t k = 0; k < cts.size(); k++) {
+    checkCipherTextSize(sk, cts[k].labels.size(), cts[k].inputs.size(), topologyOf(cts[k].garbled_info));
+  }
+
+  parallelFor(threads, cts.size(), [&](size_t begin, size_t end) {
+    std::vector<block> labels(SS_DECRYPT_BATCH_GROUP * circuit->n);
+    std::vector<const typename SS<ES>::CipherText *> group;
+    bool vals[circuit->m];
+
+    for (size_t first = begin; first < end; first += SS_DECRYPT_BATCH_GROUP) {
+      group.clear();
+      for (size_t k = first; k < std::min(end, first + SS_DECRYPT_BATCH_GROUP); k++) {
+        group.push_back(&cts[k]);
+      }
+
+      for (size_t j = 0; j < group.size(); j++) {
+        memcpy(&labels[j * circuit->n], group[j]->labels.data(), group[j]->labels.size() * sizeof(block));
+      }
+      decryptLabels(sk, group.data(), group.size(), 0, sk.bits.size(), labels.data());
+
+      for (size_t j = 0; j < group.size(); j++) {
+        evaluate(*group[j], &labels[j * circuit->n], vals);
+        results[first + j] = circuitDescription->returnVals(vals);
+      }
+    }
+  });
+
+  return results;
+}
+
+template<class ES>
+std::vector<std::vector<int> > SS<ES>::DecryptMany(const std::vector<typename SS<ES>::SecretKey> &sks,
+                                                   const typename SS<ES>::CipherText &ct) {
+  garble_circuit circuit = *topologyOf(ct.garbled_info);
+  const WireSlots &wireSlots = circuitDescription->universalCircuitWireSlots();
+  bool libgarble = ct.garbled_info.libgarbleTable();
+
+  for (const typename SS<ES>::SecretKey &sk: sks) {
+    checkCipherTextSize(sk, ct.labels.size(), ct.inputs.size(), &circuit);
+  }
+
+  // libgarble tables are unpacked into the circuit once, as garble_eval only reads it.
+  if (libgarble) {
+    ct.garbled_info.attachLibgarbleTable(&circuit);
+  }
+
+  std::vector<std::vector<int> > results(sks.size());
+  const typename SS<ES>::CipherText *cts = &ct;
+
+  parallelFor(threads, sks.size(), [&](size_t begin, size_t end) {
+    // The labels for the message are the same under every key.
+    std::vector<block> labels(circuit.n);
+    memcpy(labels.data(), ct.labels.data(), ct.labels.size() * sizeof(block));
+    bool vals[circuit.m];
+
+    for (size_t k = begin; k < end; k++) {
+      decryptLabels(sks[k], &cts, 1, 0, ct.inputs.size(), labels.data());
+
+      if (libgarble) {
+        garble_eval(&circuit, labels.data(), NULL, vals);
+      } else {
+        halfGatesEval(&circuit, wireSlots, labels.data(), ct.garbled_info, vals);
+      }
+
+      results[k] = circuitDescription->returnVals(vals);
+    }
+  });
+
+  if (libgarble) {
+    free(circuit.output_perms);
+    free(circuit.table);
+  }
+
+  return results;
+}
+
 template class SS<AESWrapper>;
 template class SS<RSAWrapper>;
 template class SS<SingletonAES>;
 template class SS<SingletonRSA>;
+template class SS<ECCWrapper>;
+template class SS<SingletonECC>;
 
@@ -1,53 +1,261 @@
 #include <assert.h>
 #include <iostream>
+#include <stdexcept>
 #include <fstream>
+#include <vector>
+#include <algorithm>
 
 #include <crypto++/aes.h>
 #include <crypto++/files.h>
 #include <crypto++/modes.h>
-#include <crypto++/osrng.h>
 
 #include "pke/pke.h"
+#include "pke/aesni.h"
+#include "util/random.h"
 
-/* AES methods.
+/* AES methods. AES-128 keys use AES-NI directly, in the same CFB mode as
+ * Crypto++, so cipher texts from either can be read by the other. Other key
+ * lengths use Crypto++.
  */
 
+// Sets roundKeys to the round keys of a 16 byte key, from its schedule unless it has none.
+static void roundKeysOf(const AESTypes::Key &key, __m128i *roundKeys) {
+  if (key.schedule) {
+    std::copy(key.schedule->roundKeys, key.schedule->roundKeys + AESNI_ROUNDS + 1, roundKeys);
+  } else {
+    aesExpandKey128(key.key.data(), roundKeys);
+  }
+}
+
+// Encrypts size bytes in CFB mode, with a block of feedback, as CFB_Mode<AES> does.
+static void cfbEncrypt(const __m128i *roundKeys, const unsigned char *iv, const unsigned char *in, unsigned char *out,
+                       size_t size) {
+  __m128i feedback = _mm_loadu_si128((const __m128i *) iv);
+
+  for (size_t i = 0; i < size; i += 16) {
+    aesEncryptBlocksFixedKey(roundKeys, &feedback, 1);
+
+    if (size - i >= 16) {
+      feedback = _mm_xor_si128(feedback, _mm_loadu_si128((const __m128i *) (in + i)));
+      _mm_storeu_si128((__m128i *) (out + i), feedback);
+    } else {
+      unsigned char stream[16];
+      _mm_storeu_si128((__m128i *) stream, feedback);
+      for (size_t j = i; j < size; j++) {
+        out[j] = in[j] ^ stream[j - i];
+      }
+    }
+  }
+}
+
+// Decrypts size bytes encrypted by cfbEncrypt. Every block of key stream is known up front, so they are made together.
+static void cfbDecrypt(const __m128i *roundKeys, const unsigned char *iv, const unsigned char *in, unsigned char *out,
+                       size_t size) {
+  __m128i stream[AESNI_PIPELINE];
+
+  for (size_t i = 0; i < size; i += 16 * AESNI_PIPELINE) {
+    size_t count = std::min((size_t) AESNI_PIPELINE, (size - i + 15) / 16);
+
+    for (size_t j = 0; j < count; j++) {
+      const unsigned char *previous = i + j == 0 ? iv : in + i + 16 * j - 16;
+      stream[j] = _mm_loadu_si128((const __m128i *) previous);
+    }
+    aesEncryptBlocksFixedKey(roundKeys, stream, count);
+
+    for (size_t j = 0; j < count; j++) {
+      size_t offset = i + 16 * j;
+
+      if (size - offset >= 16) {
+        __m128i block = _mm_xor_si128(stream[j], _mm_loadu_si128((const __m128i *) (in + offset)));
+        _mm_storeu_si128((__m128i *) (out + offset), block);
+      } else {
+        const unsigned char *bytes = (const unsigned char *) &stream[j];
+        for (size_t k = offset; k < size; k++) {
+          out[k] = in[k] ^ bytes[k - offset];
+        }
+      }
+    }
+  }
+}
+
 template<>
 AES::KeyPair AES::Setup(int length) {
   AES::SecretKey sk(0x00, length);
-  CryptoPP::AutoSeededRandomPool rng;
-  rng.GenerateBlock(sk.key, sk.key.size());
+  threadRandom().GenerateBlock(sk.key, sk.key.size());
+  sk.prepare();
   
   AES::PublicKey pk = sk;
 
   return AES::KeyPair(sk, pk);
 }
 
+template<>
+void AES::DeriveBatch(const std::vector<unsigned char> &seed, int length, const uint64_t *indices, size_t n,
+                      std::vector<AES::KeyPair> &pairs) {
+  if (seed.size() != 16) {
+    throw std::runtime_error("AES keys are derived from 16 byte seeds.");
+  }
+
+  // The PRF is AES-128 under the seed, and the key is its output on the blocks (index, 0), (index, 1), and so on.
+  __m128i roundKeys[AESNI_ROUNDS + 1];
+  aesExpandKey128(seed.data(), roundKeys);
+
+  size_t keyBlocks = (length + 15) / 16;
+  std::vector<__m128i> blocks(n * keyBlocks);
+  for (size_t i = 0; i < n; i++) {
+    for (size_t j = 0; j < keyBlocks; j++) {
+      blocks[i * keyBlocks + j] = _mm_set_epi64x(j, indices[i]);
+    }
+  }
+  aesEncryptBlocksFixedKey(roundKeys, blocks.data(), blocks.size());
+
+  pairs.reserve(pairs.size() + n);
+  for (size_t i = 0; i < n; i++) {
+    AES::SecretKey sk((unsigned char *) &blocks[i * keyBlocks], length);
+    pairs.push_back(AES::KeyPair(sk, sk));
+  }
+}
+
+template<>
+AES::KeyPair AES::Derive(const std::vector<unsigned char> &seed, int length, uint64_t index) {
+  std::vector<AES::KeyPair> pairs;
+  AES::DeriveBatch(seed, length, &index, 1, pairs);
+
+  return pairs[0];
+}
+
 template<>
 AES::CipherText AES::Encrypt(AES::PublicKey pk, AES::PlainText msg) {
   std::vector<unsigned char> iv(CryptoPP::AES::BLOCKSIZE);
-  CryptoPP::AutoSeededRandomPool rng;
-  rng.GenerateBlock(iv.data(), CryptoPP::AES::BLOCKSIZE);
-  CryptoPP::CFB_Mode<CryptoPP::AES>::Encryption e(pk.key, pk.key.size(), iv.data());
+  threadRandom().GenerateBlock(iv.data(), CryptoPP::AES::BLOCKSIZE);
 
   size_t ct_size = msg.size();
 
   AES::CipherText ct(ct_size, iv);
 
+  if (pk.key.size() == 16) {
+    __m128i roundKeys[AESNI_ROUNDS + 1];
+    roundKeysOf(pk, roundKeys);
+    cfbEncrypt(roundKeys, iv.data(), msg.data(), ct.ct.data(), msg.size());
+    return ct;
+  }
+
+  CryptoPP::CFB_Mode<CryptoPP::AES>::Encryption e(pk.key, pk.key.size(), iv.data());
   e.ProcessData(ct.ct.data(), msg.data(), msg.size());
 
   return ct;
 }
 
 template<>
-AES::PlainText AES::Decrypt(AES::SecretKey sk, AES::CipherText ct) {
-  CryptoPP::CFB_Mode<CryptoPP::AES>::Decryption d(sk.key, sk.key.size(), ct.iv.data());
+void AES::EncryptBatch(const AES::PublicKey *const *pks, const AES::PlainText *msgs, AES::CipherText *cts, size_t n) {
+  // Single block messages under AES-128 keys take the AES-NI path, since CFB mode on one block is just msg xor AES_k(iv).
+  std::vector<size_t> fast;
+  fast.reserve(n);
 
+  for (size_t i = 0; i < n; i++) {
+    if (pks[i]->key.size() == 16 && msgs[i].size() == CryptoPP::AES::BLOCKSIZE) {
+      fast.push_back(i);
+    } else {
+      cts[i] = AES::Encrypt(*pks[i], msgs[i]);
+    }
+  }
+
+  // The IVs for the whole batch come from a single call.
+  std::vector<unsigned char> ivs(fast.size() * CryptoPP::AES::BLOCKSIZE);
+  threadRandom().GenerateBlock(ivs.data(), ivs.size());
+
+  __m128i roundKeys[AESNI_PIPELINE * (AESNI_ROUNDS + 1)];
+  __m128i blocks[AESNI_PIPELINE];
+
+  for (size_t j = 0; j < fast.size(); j += AESNI_PIPELINE) {
+    size_t count = std::min((size_t) AESNI_PIPELINE, fast.size() - j);
+
+    for (size_t k = 0; k < count; k++) {
+      roundKeysOf(*pks[fast[j + k]], &roundKeys[k * (AESNI_ROUNDS + 1)]);
+      blocks[k] = _mm_loadu_si128((const __m128i *) &ivs[(j + k) * CryptoPP::AES::BLOCKSIZE]);
+    }
+
+    aesEncryptBlocks(roundKeys, blocks, count);
+
+    for (size_t k = 0; k < count; k++) {
+      size_t i = fast[j + k];
+      const unsigned char *iv = &ivs[(j + k) * CryptoPP::AES::BLOCKSIZE];
+
+      cts[i] = AES::CipherText(CryptoPP::AES::BLOCKSIZE, std::vector<unsigned char>(iv, iv + CryptoPP::AES::BLOCKSIZE));
+
+      __m128i msg = _mm_loadu_si128((const __m128i *) msgs[i].data());
+      _mm_storeu_si128((__m128i *) cts[i].ct.data(), _mm_xor_si128(msg, blocks[k]));
+    }
+  }
+}
+
+template<>
+AES::PlainText AES::Decrypt(const AES::SecretKey &sk, const AES::CipherText &ct) {
   size_t pt_size = ct.ct.size();
 
   AES::PlainText pt(pt_size);
 
+  if (sk.key.size() == 16 && ct.iv.size() == CryptoPP::AES::BLOCKSIZE) {
+    __m128i roundKeys[AESNI_ROUNDS + 1];
+    roundKeysOf(sk, roundKeys);
+    cfbDecrypt(roundKeys, ct.iv.data(), ct.ct.data(), pt.data(), ct.ct.size());
+    return pt;
+  }
+
+  CryptoPP::CFB_Mode<CryptoPP::AES>::Decryption d(sk.key, sk.key.size(), ct.iv.data());
   d.ProcessData(pt.data(), ct.ct.data(), ct.ct.size());
 
   return pt;
 }
+
+template<>
+void AES::DecryptBatch(const AES::SecretKey *const *sks, const AES::CipherText *const *cts, AES::PlainText *pts, size_t n) {
+  // As in EncryptBatch, single block cipher texts under AES-128 keys take the AES-NI path, since CFB mode on one
+  // block is just ct xor AES_k(iv). Round keys are only copied from a key when it differs from the key before it.
+  std::vector<size_t> fast;
+  fast.reserve(n);
+
+  for (size_t i = 0; i < n; i++) {
+    if (sks[i]->key.size() == 16 && cts[i]->ct.size() == CryptoPP::AES::BLOCKSIZE &&
+        cts[i]->iv.size() == CryptoPP::AES::BLOCKSIZE) {
+      fast.push_back(i);
+    } else {
+      pts[i] = AES::Decrypt(*sks[i], *cts[i]);
+    }
+  }
+
+  __m128i roundKeys[AESNI_PIPELINE * (AESNI_ROUNDS + 1)];
+  __m128i blocks[AESNI_PIPELINE];
+  const AES::SecretKey *previous = NULL;
+  const __m128i *previousRoundKeys = NULL;
+
+  for (size_t j = 0; j < fast.size(); j += AESNI_PIPELINE) {
+    size_t count = std::min((size_t) AESNI_PIPELINE, fast.size() - j);
+
+    for (size_t k = 0; k < count; k++) {
+      const AES::SecretKey *sk = sks[fast[j + k]];
+      __m128i *keys = &roundKeys[k * (AESNI_ROUNDS + 1)];
+
+      if (sk == previous) {
+        std::copy(previousRoundKeys, previousRoundKeys + AESNI_ROUNDS + 1, keys);
+      } else {
+        roundKeysOf(*sk, keys);
+      }
+
+      previous = sk;
+      previousRoundKeys = keys;
+      blocks[k] = _mm_loadu_si128((const __m128i *) cts[fast[j + k]]->iv.data());
+    }
+
+    aesEncryptBlocks(roundKeys, blocks, count);
+
+    for (size_t k = 0; k < count; k++) {
+      size_t i = fast[j + k];
+
+      pts[i].resize(CryptoPP::AES::BLOCKSIZE);
+
+      __m128i ct = _mm_loadu_si128((const __m128i *) cts[i]->ct.data());
+      _mm_storeu_si128((__m128i *) pts[i].data(), _mm_xor_si128(ct, blocks[k]));
+    }
+  }
+}
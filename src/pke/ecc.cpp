@@ -0,0 +1,87 @@
+#include <assert.h>
+#include <iostream>
+#include <stdexcept>
+
+#include <crypto++/eccrypto.h>
+#include <crypto++/oids.h>
+
+#include "pke/pke.h"
+#include "util/random.h"
+
+/* ECIES methods, over NIST P-256. The ephemeral point in each cipher text
+ * is compressed, so a single block message takes 33 + 16 + 20 bytes.
+ */
+
+template<>
+ECC::KeyPair ECC::Setup(int length) {
+  if (length != ECC_KEYLENGTH) {
+    throw std::runtime_error("ECC keys are only supported on a 256 bit curve.");
+  }
+
+  ECC::SecretKey sk;
+  sk.sk.Initialize(threadRandom(), CryptoPP::ASN1::secp256r1());
+
+  ECC::PublicKey pk(sk);
+
+  return ECC::KeyPair(sk, pk);
+}
+
+template<>
+ECC::KeyPair ECC::Derive(const std::vector<unsigned char> &seed, int length, uint64_t index) {
+  (void) seed;
+  (void) length;
+  (void) index;
+  throw std::runtime_error("ECC keys cannot be derived from a seed.");
+}
+
+template<>
+void ECC::DeriveBatch(const std::vector<unsigned char> &seed, int length, const uint64_t *indices, size_t n,
+                      std::vector<ECC::KeyPair> &pairs) {
+  (void) seed;
+  (void) length;
+  (void) indices;
+  (void) n;
+  (void) pairs;
+  throw std::runtime_error("ECC keys cannot be derived from a seed.");
+}
+
+template<>
+ECC::CipherText ECC::Encrypt(ECC::PublicKey pk, ECC::PlainText msg) {
+  ECCTypes::Scheme::Encryptor e(pk.pk);
+  e.AccessKey().AccessGroupParameters().SetPointCompression(true);
+
+  ECC::CipherText ct(e.CiphertextLength(msg.size()));
+  e.Encrypt(threadRandom(), msg.data(), msg.size(), ct.ct.data());
+
+  return ct;
+}
+
+template<>
+void ECC::EncryptBatch(const ECC::PublicKey *const *pks, const ECC::PlainText *msgs, ECC::CipherText *cts, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    cts[i] = ECC::Encrypt(*pks[i], msgs[i]);
+  }
+}
+
+template<>
+ECC::PlainText ECC::Decrypt(const ECC::SecretKey &sk, const ECC::CipherText &ct) {
+  ECCTypes::Scheme::Decryptor d(sk.sk);
+  d.AccessKey().AccessGroupParameters().SetPointCompression(true);
+
+  ECC::PlainText pt(d.MaxPlaintextLength(ct.ct.size()));
+  CryptoPP::DecodingResult result = d.Decrypt(threadRandom(), ct.ct.data(), ct.ct.size(), pt.data());
+
+  if (!result.isValidCoding) {
+    throw std::runtime_error("ECC cipher text failed to decrypt.");
+  }
+  pt.resize(result.messageLength);
+
+  return pt;
+}
+
+template<>
+void ECC::DecryptBatch(const ECC::SecretKey *const *sks, const ECC::CipherText *const *cts, ECC::PlainText *pts, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    pts[i] = ECC::Decrypt(*sks[i], *cts[i]);
+  }
+}
@@ -1,53 +1,171 @@
 #include <assert.h>
 #include <iostream>
+#include <stdexcept>
+#include <future>
 
 #include <crypto++/rsa.h>
-#include <crypto++/osrng.h>
 #include <crypto++/files.h>
 #include <crypto++/base64.h>
+#include <crypto++/modarith.h>
+#include <crypto++/nbtheory.h>
+#include <crypto++/oaep.h>
+#include <crypto++/sha.h>
 
 #include "pke/pke.h"
+#include "util/random.h"
+#include "util/parallel.h"
 
 /* RSA methods.
  */
 
+// Batches of at least this many cipher texts are decrypted with the halves mod p and mod q on two threads, unless
+// already in a parallelFor.
+#define RSA_CRT_THREAD_MIN 2
+
 template<>
 RSA::KeyPair RSA::Setup(int length) {
   RSA::SecretKey sk;
-  CryptoPP::AutoSeededRandomPool rng;
-  sk.sk.GenerateRandomWithKeySize(rng, length);
+  sk.sk.GenerateRandomWithKeySize(threadRandom(), length);
   
   RSA::PublicKey pk(sk);
 
   return RSA::KeyPair(sk, pk);
 }
 
+template<>
+RSA::KeyPair RSA::Derive(const std::vector<unsigned char> &seed, int length, uint64_t index) {
+  (void) seed;
+  (void) length;
+  (void) index;
+  throw std::runtime_error("RSA keys cannot be derived from a seed.");
+}
+
+template<>
+void RSA::DeriveBatch(const std::vector<unsigned char> &seed, int length, const uint64_t *indices, size_t n,
+                      std::vector<RSA::KeyPair> &pairs) {
+  (void) seed;
+  (void) length;
+  (void) indices;
+  (void) n;
+  (void) pairs;
+  throw std::runtime_error("RSA keys cannot be derived from a seed.");
+}
+
 template<>
 RSA::CipherText RSA::Encrypt(RSA::PublicKey pk, RSA::PlainText msg) {
-  CryptoPP::RSAES_OAEP_SHA_Encryptor e(pk.pk);
+  // Keys made or unpacked by us come with an encryptor.
+  std::shared_ptr<const CryptoPP::RSAES_OAEP_SHA_Encryptor> e = pk.encryptor;
+  if (!e) {
+    e = std::make_shared<CryptoPP::RSAES_OAEP_SHA_Encryptor>(pk.pk);
+  }
 
-  size_t ct_size = e.CiphertextLength(msg.size());
+  size_t ct_size = e->CiphertextLength(msg.size());
 
   RSA::CipherText ct(ct_size);
-  CryptoPP::AutoSeededRandomPool rng;
 
-  CryptoPP::ArraySource ss(msg.data(), msg.size(), true,
-      new CryptoPP::PK_EncryptorFilter(rng, e, new CryptoPP::ArraySink(ct.ct.data(), ct.ct.size())));
+  e->Encrypt(threadRandom(), msg.data(), msg.size(), ct.ct.data());
 
   return ct;
 }
 
 template<>
-RSA::PlainText RSA::Decrypt(RSA::SecretKey sk, RSA::CipherText ct) {
-  CryptoPP::RSAES_OAEP_SHA_Decryptor d(sk.sk);
+void RSA::EncryptBatch(const RSA::PublicKey *const *pks, const RSA::PlainText *msgs, RSA::CipherText *cts, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    cts[i] = RSA::Encrypt(*pks[i], msgs[i]);
+  }
+}
+
+template<>
+void RSA::DecryptBatch(const RSA::SecretKey *const *sks, const RSA::CipherText *const *cts, RSA::PlainText *pts, size_t n) {
+  // As in Crypto++, each cipher text x is blinded by r^e for a random r, its root is found mod p and mod q and joined
+  // by CRT, and the result is checked with the public exponent before it is unpadded. The roots mod p of the whole
+  // batch are found on this thread while the roots mod q are found on another.
+  std::vector<CryptoPP::Integer> xs(n), blinded(n), unblinders(n), rootsP(n), rootsQ(n);
+
+  for (size_t i = 0; i < n; i++) {
+    const CryptoPP::RSA::PrivateKey &k = sks[i]->sk;
+    const CryptoPP::Integer &modulus = k.GetModulus();
+    CryptoPP::ModularArithmetic modn(modulus);
+
+    xs[i] = CryptoPP::Integer(cts[i]->ct.data(), cts[i]->ct.size());
+    if (cts[i]->ct.size() != modulus.ByteCount() || xs[i] >= modulus) {
+      throw std::runtime_error("RSA cipher text does not fit the key.");
+    }
+
+    CryptoPP::Integer r;
+    do {
+      r.Randomize(threadRandom(), CryptoPP::Integer::One(), modulus - CryptoPP::Integer::One());
+      unblinders[i] = modn.MultiplicativeInverse(r);
+    } while (unblinders[i].IsZero());
 
-  size_t pt_size = d.MaxPlaintextLength(ct.ct.size());
+    blinded[i] = modn.Multiply(modn.Exponentiate(r, k.GetPublicExponent()), xs[i]);
+  }
 
-  RSA::PlainText pt(pt_size);
-  CryptoPP::AutoSeededRandomPool rng;
+  auto rootsModQ = [&] {
+    for (size_t i = 0; i < n; i++) {
+      const CryptoPP::RSA::PrivateKey &k = sks[i]->sk;
+      rootsQ[i] = CryptoPP::ModularExponentiation(blinded[i] % k.GetPrime2(), k.GetModPrime2PrivateExponent(),
+                                                  k.GetPrime2());
+    }
+  };
+
+  // The future waits for the roots mod q when destroyed, so they are done with the batch even if this thread throws.
+  std::future<void> rootsQDone;
+  if (n >= RSA_CRT_THREAD_MIN && !inParallelFor()) {
+    rootsQDone = std::async(std::launch::async, rootsModQ);
+  } else {
+    rootsModQ();
+  }
+
+  for (size_t i = 0; i < n; i++) {
+    const CryptoPP::RSA::PrivateKey &k = sks[i]->sk;
+    rootsP[i] = CryptoPP::ModularExponentiation(blinded[i] % k.GetPrime1(), k.GetModPrime1PrivateExponent(),
+                                                k.GetPrime1());
+  }
+
+  if (rootsQDone.valid()) {
+    rootsQDone.get();
+  }
+
+  CryptoPP::OAEP<CryptoPP::SHA1> oaep;
+
+  for (size_t i = 0; i < n; i++) {
+    const CryptoPP::RSA::PrivateKey &k = sks[i]->sk;
+    const CryptoPP::Integer &modulus = k.GetModulus();
+    CryptoPP::ModularArithmetic modn(modulus);
+
+    // The inverse of q mod p is kept with the key, so CRT is given the root mod q first.
+    CryptoPP::Integer y = CryptoPP::CRT(rootsQ[i], k.GetPrime2(), rootsP[i], k.GetPrime1(),
+                                        k.GetMultiplicativeInverseOfPrime2ModPrime1());
+    y = modn.Multiply(y, unblinders[i]);
+
+    if (modn.Exponentiate(y, k.GetPublicExponent()) != xs[i]) {
+      throw std::runtime_error("RSA private key operation failed.");
+    }
+
+    size_t paddedBits = modulus.BitCount() - 1;
+    std::vector<unsigned char> padded((paddedBits + 7) / 8);
+    if (y.ByteCount() > padded.size()) {
+      y = CryptoPP::Integer::Zero();
+    }
+    y.Encode(padded.data(), padded.size());
+
+    // As before, the plain text is as long as the longest message, with the message at the start.
+    pts[i].assign(oaep.MaxUnpaddedLength(paddedBits), 0);
+    CryptoPP::DecodingResult result = oaep.Unpad(padded.data(), paddedBits, pts[i].data(), CryptoPP::g_nullNameValuePairs);
+    if (!result.isValidCoding) {
+      throw std::runtime_error("RSA cipher text is not validly padded.");
+    }
+  }
+}
+
+template<>
+RSA::PlainText RSA::Decrypt(const RSA::SecretKey &sk, const RSA::CipherText &ct) {
+  const RSA::SecretKey *sks = &sk;
+  const RSA::CipherText *cts = &ct;
+  RSA::PlainText pt;
 
-  CryptoPP::ArraySource ss(ct.ct.data(), ct.ct.size(), true, 
-      new CryptoPP::PK_DecryptorFilter(rng, d, new CryptoPP::ArraySink(pt.data(), pt.size())));
+  RSA::DecryptBatch(&sks, &cts, &pt, 1);
 
   return pt;
 }
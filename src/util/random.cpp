@@ -0,0 +1,76 @@
+#include <cstring>
+#include <algorithm>
+
+#include <crypto++/osrng.h>
+
+#include "util/random.h"
+
+// Bytes of output in the buffer, which follow the block used as the next key.
+static const size_t OUTPUT_BYTES = (RANDOM_BUFFER_BLOCKS - 1) * sizeof(__m128i);
+
+AesCtrRandom::AesCtrRandom(): counter(0), used(OUTPUT_BYTES) {
+  unsigned char seed[16];
+  CryptoPP::AutoSeededRandomPool rng;
+  rng.GenerateBlock(seed, sizeof(seed));
+
+  aesExpandKey128(seed, roundKeys);
+  memset(seed, 0, sizeof(seed));
+}
+
+void AesCtrRandom::refill() {
+  for (size_t j = 0; j < RANDOM_BUFFER_BLOCKS; j++) {
+    buffer[j] = _mm_set_epi64x(0, counter++);
+  }
+  aesEncryptBlocksFixedKey(roundKeys, buffer, RANDOM_BUFFER_BLOCKS);
+
+  // The first block is the next key, and is never given out.
+  aesExpandKey128((const unsigned char *) &buffer[0], roundKeys);
+  buffer[0] = _mm_setzero_si128();
+  used = 0;
+}
+
+void AesCtrRandom::GenerateBlock(unsigned char *output, size_t size) {
+  unsigned char *bytes = (unsigned char *) (buffer + 1);
+
+  while (size > 0) {
+    if (used == OUTPUT_BYTES) {
+      refill();
+    }
+
+    // Output is wiped once given out.
+    size_t n = std::min(size, OUTPUT_BYTES - used);
+    memcpy(output, bytes + used, n);
+    memset(bytes + used, 0, n);
+
+    used += n;
+    output += n;
+    size -= n;
+  }
+}
+
+void AesCtrRandom::fillBlocks(__m128i *blocks, size_t n) {
+  GenerateBlock((unsigned char *) blocks, n * sizeof(__m128i));
+}
+
+uint64_t AesCtrRandom::uniform(uint64_t n) {
+  // Rejects the lowest 2^64 mod n values, so the rest split evenly into n classes.
+  uint64_t threshold = (0 - n) % n;
+
+  while (true) {
+    uint64_t x = (*this)();
+    if (x >= threshold) {
+      return x % n;
+    }
+  }
+}
+
+AesCtrRandom::result_type AesCtrRandom::operator()() {
+  result_type x;
+  GenerateBlock((unsigned char *) &x, sizeof(x));
+  return x;
+}
+
+AesCtrRandom &threadRandom() {
+  static thread_local AesCtrRandom rng;
+  return rng;
+}
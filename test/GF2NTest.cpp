@@ -95,6 +95,21 @@ TEST_F(GF2NTest, ReduceGF2NByIrredPolySecond) {
   EXPECT_EQ(1, (int) vals[2]);
 }
 
+TEST_F(GF2NTest, multiplyGF2NKaratsuba) {
+  int n = 16, m = 8;
+  // x^8 = x^4 + x^3 + x + 1, as in AES, where 0x53 and 0xCA are inverses.
+  int aesPoly[8] = {1,1,0,1,1,0,0,0};
+
+  start(n, m);
+  multiplyGF2NKaratsuba(gc, ctxt, inp, inp + m, outputs, m, aesPoly);
+  finishGarbleAndEval(n, m, {1,1,0,0,1,0,1,0, 0,1,0,1,0,0,1,1});
+
+  EXPECT_EQ(1, (int) vals[0]);
+  for (int i = 1; i < m; i++) {
+    EXPECT_EQ(0, (int) vals[i]);
+  }
+}
+
 TEST_F(GF2NTest, innerProductGF2NCircuit) {
   int n = 6, m = 3;
 
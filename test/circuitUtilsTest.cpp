@@ -103,6 +103,29 @@ TEST_F(CircuitTest, ORGate) {
   EXPECT_EQ(1, (int) vals[3]);
 }
 
+TEST_F(CircuitTest, constantFolding) {
+  int n = 2, m = 4;
+
+  start(n, m);
+  EXPECT_EQ(wire_zero(gc), gateAND(gc, ctxt, inp[0], wire_zero(gc)));
+  EXPECT_EQ(inp[0], gateAND(gc, ctxt, wire_one(gc), inp[0]));
+  EXPECT_EQ(inp[1], gateXOR(gc, ctxt, wire_zero(gc), inp[1]));
+  EXPECT_EQ(wire_zero(gc), gateXOR(gc, ctxt, inp[1], inp[1]));
+  EXPECT_EQ(wire_one(gc), gateOR(gc, ctxt, inp[0], wire_one(gc)));
+  EXPECT_EQ(wire_one(gc), gateNOT(gc, ctxt, wire_zero(gc)));
+
+  outputs[0] = gateAND(gc, ctxt, inp[0], inp[1]);
+  outputs[1] = gateXOR(gc, ctxt, inp[0], inp[1]);
+  outputs[2] = gateOR(gc, ctxt, inp[0], inp[1]);
+  outputs[3] = gateNOT(gc, ctxt, inp[0]);
+  finishGarbleAndEval(n, m, {1,0});
+
+  EXPECT_EQ(0, (int) vals[0]);
+  EXPECT_EQ(1, (int) vals[1]);
+  EXPECT_EQ(1, (int) vals[2]);
+  EXPECT_EQ(0, (int) vals[3]);
+}
+
 TEST_F(CircuitTest, ZeroWire) {
   int n = 8, m = 1;
 
@@ -241,6 +264,57 @@ TEST_F(CircuitTest, multiplyModP) {
   EXPECT_EQ(0, (int) vals[3]);
 }
 
+TEST_F(CircuitTest, reduceWideModP) {
+  int n = 12, m = 4;
+  int p[4] = {1,1,0,1};
+
+  start(n, m);
+  reduceWideModP(gc, ctxt, inp, n, outputs, m, p);
+  std::vector<int> input(n);
+  int x = 3000;
+  for (int i = 0; i < n; i++) {
+    input[i] = x % 2;
+    x /= 2;
+  }
+  finishGarbleAndEval(n, m, input);
+
+  EXPECT_EQ(0, (int) vals[0]);
+  EXPECT_EQ(0, (int) vals[1]);
+  EXPECT_EQ(0, (int) vals[2]);
+  EXPECT_EQ(1, (int) vals[3]);
+}
+
+TEST_F(CircuitTest, multiplyModPKaratsuba) {
+  int n = 48, m = 24;
+  long long mod = 16777213;
+  int p[24];
+  for (int i = 0; i < m; i++) {
+    p[i] = (mod >> i) & 1;
+  }
+
+  start(n, m);
+  multiplyModPKaratsuba(gc, ctxt, inp, inp + m, outputs, m, p);
+  std::vector<int> input(n);
+  long long x = 1234567, y = 7654321;
+  long long expected = x * y % mod;
+  for (int i = 0; i < m; i++) {
+    input[i] = x % 2;
+    input[i + m] = y % 2;
+    x /= 2;
+    y /= 2;
+  }
+  finishGarbleAndEval(n, m, input);
+
+  long long z = 0;
+
+  for (int i = m - 1; i >= 0; i--) {
+    z *= 2;
+    z += vals[i];
+  }
+
+  EXPECT_EQ(expected, z);
+}
+
 TEST_F(CircuitTest, add32) {
   int n = 64, m = 32;
 
@@ -293,6 +367,32 @@ TEST_F(CircuitTest, multiply32) {
   EXPECT_EQ(expected, z);
 }
 
+TEST_F(CircuitTest, multiply32Karatsuba) {
+  int n = 64, m = 32;
+
+  start(n, m);
+  multiply32Karatsuba(gc, ctxt, inp, inp + 32, outputs);
+  std::vector<int> input(64);
+  unsigned int x = 1282048, y = 974027482;
+  unsigned int expected = x * y;
+  for (int i = 0; i < 32; i++) {
+    input[i] = x % 2;
+    input[i + 32] = y % 2;
+    x /= 2;
+    y /= 2;
+  }
+  finishGarbleAndEval(n, m, input);
+
+  unsigned int z = 0;
+
+  for (int i = 31; i >= 0; i--) {
+    z *= 2;
+    z += vals[i];
+  }
+
+  EXPECT_EQ(expected, z);
+}
+
 TEST_F(CircuitTest, hamming) {
   int n = 8, m = 3;
 
@@ -311,3 +411,26 @@ TEST_F(CircuitTest, hamming) {
   EXPECT_EQ(2, z);
 }
 
+
+TEST_F(CircuitTest, popcount) {
+  int n = 23, m = 5;
+
+  start(n, m);
+  popcount(gc, ctxt, inp, outputs, n);
+  std::vector<int> input(n);
+  int expected = 0;
+  for (int i = 0; i < n; i++) {
+    input[i] = (i % 3 != 1);
+    expected += input[i];
+  }
+  finishGarbleAndEval(n, m, input);
+
+  int z = 0;
+
+  for (int i = m - 1; i >= 0; i--) {
+    z *= 2;
+    z += vals[i];
+  }
+
+  EXPECT_EQ(expected, z);
+}
@@ -1,8 +1,14 @@
 #include <vector>
 #include <iostream>
+#include <fstream>
+#include <thread>
+#include <chrono>
+
+#include <crypto++/modes.h>
 
 #include "pke/pke.h"
 #include "oneqfe/ss.h"
+#include "util/parallel.h"
 #include "bounded/gvw.h"
 
 #include "gtest/gtest.h"
@@ -36,6 +42,77 @@ TEST_F(FileTest, AESKey) {
   AES::PlainText msg_pt(bytes, bytes + msg.size());
 
   EXPECT_EQ(msg_pt, aes.Decrypt(p.sk, aes.Encrypt(pk, msg_pt)));
+
+  // Round keys are made once, when the key is made or read, and shared by its copies.
+  ASSERT_TRUE(pk.schedule != nullptr);
+  AES::PublicKey copy = pk;
+  EXPECT_EQ(pk.schedule, copy.schedule);
+  EXPECT_EQ(nullptr, aes.Setup(32).sk.schedule);
+}
+
+TEST_F(FileTest, AESBatch) {
+  AES aes;
+  std::vector<AES::PublicKey> keys;
+  std::vector<const AES::PublicKey *> pks;
+  std::vector<AES::PlainText> msgs;
+
+  // Includes a message that is not a single block, which does not use the AES-NI path.
+  for (int i = 0; i < 20; i++) {
+    keys.push_back(aes.Setup(AES_DEFAULT_KEYLENGTH).pk);
+    msgs.push_back(AES::PlainText(i == 7 ? 5 : 16, (unsigned char) i));
+  }
+  for (auto &key: keys) {
+    pks.push_back(&key);
+  }
+
+  std::vector<AES::CipherText> cts(keys.size());
+  aes.EncryptBatch(pks.data(), msgs.data(), cts.data(), keys.size());
+
+  for (size_t i = 0; i < keys.size(); i++) {
+    EXPECT_EQ(msgs[i], aes.Decrypt(keys[i], cts[i]));
+  }
+
+  // Repeats keys, as consecutive cipher texts under one key share its round keys.
+  std::vector<const AES::CipherText *> ctPtrs;
+  for (size_t i = 0; i < keys.size(); i++) {
+    pks[i] = &keys[i / 3];
+    ctPtrs.push_back(&cts[i]);
+  }
+  aes.EncryptBatch(pks.data(), msgs.data(), cts.data(), keys.size());
+
+  std::vector<AES::PlainText> pts(keys.size());
+  aes.DecryptBatch(pks.data(), ctPtrs.data(), pts.data(), keys.size());
+  EXPECT_EQ(msgs, pts);
+}
+
+TEST_F(FileTest, AESCFBCompatible) {
+  AES aes;
+  AES::SecretKey sk = aes.Setup(AES_DEFAULT_KEYLENGTH).sk;
+
+  // Cipher texts must match those of Crypto++, including partial and many blocks.
+  for (size_t size: {0, 1, 15, 16, 17, 100, 300}) {
+    AES::PlainText msg(size);
+    for (size_t i = 0; i < size; i++) {
+      msg[i] = (unsigned char) (7 * i + 3);
+    }
+
+    AES::CipherText ct = aes.Encrypt(sk, msg);
+    AES::PlainText pt(size);
+    CryptoPP::CFB_Mode<CryptoPP::AES>::Decryption d(sk.key, sk.key.size(), ct.iv.data());
+    d.ProcessData(pt.data(), ct.ct.data(), ct.ct.size());
+    EXPECT_EQ(msg, pt);
+
+    AES::CipherText ct2(size, ct.iv);
+    CryptoPP::CFB_Mode<CryptoPP::AES>::Encryption e(sk.key, sk.key.size(), ct.iv.data());
+    e.ProcessData(ct2.ct.data(), msg.data(), msg.size());
+    EXPECT_EQ(ct.ct, ct2.ct);
+    EXPECT_EQ(msg, aes.Decrypt(sk, ct2));
+  }
+
+  // Longer keys still work.
+  AES::SecretKey longKey = aes.Setup(32).sk;
+  AES::PlainText msg(40, 9);
+  EXPECT_EQ(msg, aes.Decrypt(longKey, aes.Encrypt(longKey, msg)));
 }
 
 TEST_F(FileTest, RSAKeys) {
@@ -65,6 +142,105 @@ TEST_F(FileTest, RSAKeys) {
   EXPECT_EQ(msg_pt, out2);
 }
 
+TEST_F(FileTest, RSABatch) {
+  RSA rsa;
+  std::vector<RSA::KeyPair> keys = {rsa.Setup(1024), rsa.Setup(1024)};
+  std::vector<const RSA::SecretKey *> sks;
+  std::vector<RSA::CipherText> cts;
+  std::vector<const RSA::CipherText *> ctPtrs;
+  std::vector<RSA::PlainText> msgs;
+
+  for (int i = 0; i < 6; i++) {
+    msgs.push_back(RSA::PlainText(16, (unsigned char) i));
+    cts.push_back(rsa.Encrypt(keys[i % 2].pk, msgs[i]));
+    sks.push_back(&keys[i % 2].sk);
+  }
+  for (auto &ct: cts) {
+    ctPtrs.push_back(&ct);
+  }
+
+  std::vector<RSA::PlainText> pts(cts.size());
+  rsa.DecryptBatch(sks.data(), ctPtrs.data(), pts.data(), cts.size());
+
+  for (size_t i = 0; i < cts.size(); i++) {
+    EXPECT_EQ(rsa.Decrypt(*sks[i], cts[i]), pts[i]);
+    pts[i].resize(msgs[i].size());
+    EXPECT_EQ(msgs[i], pts[i]);
+  }
+
+  // Within a parallelFor, each half of the batch is decrypted on the chunk's own thread.
+  std::vector<RSA::PlainText> chunkPts(cts.size());
+  parallelFor(2, 2, [&](size_t begin, size_t end) {
+    EXPECT_TRUE(inParallelFor());
+    for (size_t t = begin; t < end; t++) {
+      rsa.DecryptBatch(&sks[3 * t], &ctPtrs[3 * t], &chunkPts[3 * t], 3);
+    }
+  });
+  EXPECT_FALSE(inParallelFor());
+  for (size_t i = 0; i < cts.size(); i++) {
+    chunkPts[i].resize(msgs[i].size());
+    EXPECT_EQ(msgs[i], chunkPts[i]);
+  }
+
+  // A cipher text under the other key is rejected, also in a batch, which must not leave the other thread running.
+  EXPECT_ANY_THROW(rsa.Decrypt(keys[1].sk, cts[0]));
+  sks[0] = &keys[1].sk;
+  EXPECT_ANY_THROW(rsa.DecryptBatch(sks.data(), ctPtrs.data(), pts.data(), cts.size()));
+}
+
+TEST_F(FileTest, ECCKeys) {
+  ECC ecc;
+  ECC::KeyPair p = ecc.Setup(ECC_KEYLENGTH);
+
+  ECC::PublicKey pk;
+  ECC::SecretKey sk;
+
+  writeToFile(p.pk, "test/tmp/tmp-ecc-pk");
+  writeToFile(p.sk, "test/tmp/tmp-ecc-sk");
+  readFromFile(pk, "test/tmp/tmp-ecc-pk");
+  readFromFile(sk, "test/tmp/tmp-ecc-sk");
+
+  ECC::PlainText msg(16, 5);
+  ECC::CipherText ct = ecc.Encrypt(pk, msg);
+
+  // The ephemeral point is compressed.
+  EXPECT_EQ(33 + 16 + 20, ct.ct.size());
+  EXPECT_EQ(msg, ecc.Decrypt(p.sk, ct));
+  EXPECT_EQ(msg, ecc.Decrypt(sk, ecc.Encrypt(p.pk, msg)));
+  EXPECT_THROW(ecc.Setup(3072), std::runtime_error);
+}
+
+TEST_F(FileTest, SSECC) {
+  Circuit *circuit = new InnerProductModPCircuit(101, {11, 2, 45, 13});
+  std::vector<int> x = {100, 97, 3, 17};
+  CircuitDescription *desc = new InnerProductModPCircuitDescription(101, 4);
+
+  SS_ECC fe(desc, 2);
+  SS_ECC::KeyPair p = fe.Setup(ECC_KEYLENGTH);
+  SS_ECC::MasterPublicKey mpkRead;
+  SS_ECC::SecretKey sk = fe.KeyGen(p.sk, circuit), skRead;
+  writeToFile(p.pk, "test/tmp/tmp-oneqfe-mpk");
+  readFromFile(mpkRead, "test/tmp/tmp-oneqfe-mpk");
+  writeToFile(sk, "test/tmp/tmp-oneqfe-sk");
+  readFromFile(skRead, "test/tmp/tmp-oneqfe-sk");
+
+  EXPECT_EQ(34, fe.Decrypt(skRead, fe.Encrypt(mpkRead, x))[0]);
+
+  SS_SingletonECC singletonFe(desc);
+  SS_SingletonECC::KeyPair singletonP = singletonFe.Setup(ECC_KEYLENGTH);
+  SS_SingletonECC::SecretKey singletonSk = singletonFe.KeyGen(singletonP.sk, circuit);
+  EXPECT_EQ(34, singletonFe.Decrypt(singletonSk, singletonFe.Encrypt(singletonP.pk, x))[0]);
+
+  // Failures on any of the threads reach the caller.
+  SS_ECC::CipherText ct = fe.Encrypt(p.pk, x);
+  for (auto &input: ct.inputs) {
+    input.first.ct[1] ^= 1;
+    input.second.ct[1] ^= 1;
+  }
+  EXPECT_THROW(fe.Decrypt(sk, ct), std::exception);
+  EXPECT_THROW(fe.DecryptBatch(sk, {ct, ct, ct}), std::exception);
+}
+
 TEST_F(FileTest, SSKeys) {
   Circuit *circuit = new InnerProductModPCircuit(101, {11, 2, 45, 13});
   std::vector<int> x = {100, 97, 3, 17};
@@ -111,6 +287,20 @@ TEST_F(FileTest, SSSecretKey) {
 
   EXPECT_EQ(34, pt[0]);
   EXPECT_EQ(pt, pt2);
+  EXPECT_EQ(sk.bits, skRead.bits);
+
+  // Keys with a msgpack int for each bit must stay readable.
+  SS_AES::SecretKey skOld;
+  std::ofstream file("test/tmp/tmp-oneqfe-sk");
+  msgpack::packer<std::ofstream> pk(file);
+  pk.pack_array(2);
+  pk.pack(sk.bits);
+  pk.pack(sk.sks);
+  file.close();
+  readFromFile(skOld, "test/tmp/tmp-oneqfe-sk");
+
+  EXPECT_EQ(sk.bits, skOld.bits);
+  EXPECT_EQ(pt, fe.Decrypt(skOld, ct));
 }
 
 TEST_F(FileTest, SSCipherText) {
@@ -133,6 +323,413 @@ TEST_F(FileTest, SSCipherText) {
   EXPECT_EQ(pt, pt2);
 }
 
+TEST_F(FileTest, SSDecryptFromFile) {
+  Circuit *circuit = new InnerProductModPCircuit(101, {11, 2, 45, 13});
+  std::vector<int> x = {100, 97, 3, 17};
+  SS_AES fe(new InnerProductModPCircuitDescription(101, 4), 2);
+  SS_AES::KeyPair p = fe.Setup(AES_DEFAULT_KEYLENGTH);
+  SS_AES::SecretKey sk = fe.KeyGen(p.sk, circuit);
+  SS_AES::CipherText ct = fe.Encrypt(p.pk, x);
+
+  writeToFile(ct, "test/tmp/tmp-oneqfe-ct");
+  std::vector<int> pt = fe.DecryptFromFile(sk, "test/tmp/tmp-oneqfe-ct");
+
+  EXPECT_EQ(34, pt[0]);
+  EXPECT_EQ(fe.Decrypt(sk, ct), pt);
+
+  // Keys for other circuits, and files cut short in the table, are rejected.
+  SS_AES::SecretKey shortKey = sk;
+  shortKey.bits.pop_back();
+  shortKey.sks.pop_back();
+  EXPECT_THROW(fe.DecryptFromFile(shortKey, "test/tmp/tmp-oneqfe-ct"), std::runtime_error);
+
+  std::ifstream whole("test/tmp/tmp-oneqfe-ct", std::ios::binary);
+  std::string bytes((std::istreambuf_iterator<char>(whole)), std::istreambuf_iterator<char>());
+  std::ofstream cut("test/tmp/tmp-oneqfe-ct-cut", std::ios::binary);
+  cut.write(bytes.data(), 200);
+  cut.close();
+  EXPECT_THROW(fe.DecryptFromFile(sk, "test/tmp/tmp-oneqfe-ct-cut"), msgpack::type_error);
+
+  // Older cipher texts are read whole.
+  ct.garbled_info.version = GARBLED_INFO_VERSION_HALF_GATES;
+  writeToFile(ct, "test/tmp/tmp-oneqfe-ct");
+
+  EXPECT_EQ(pt, fe.DecryptFromFile(sk, "test/tmp/tmp-oneqfe-ct"));
+
+  EXPECT_THROW(fe.DecryptFromFile(sk, "test/tmp/tmp-oneqfe-missing"), std::runtime_error);
+}
+
+TEST_F(FileTest, SSEncryptToStream) {
+  Circuit *circuit = new InnerProductModPCircuit(101, {11, 2, 45, 13});
+  std::vector<int> x = {100, 97, 3, 17};
+  SS_AES fe(new InnerProductModPCircuitDescription(101, 4));
+  SS_AES::KeyPair p = fe.Setup(AES_DEFAULT_KEYLENGTH);
+  SS_AES::SecretKey sk = fe.KeyGen(p.sk, circuit);
+
+  std::ofstream file("test/tmp/tmp-oneqfe-ct", std::ios::out | std::ios::binary);
+  fe.Encrypt(p.pk, x, file);
+  file.close();
+
+  SS_AES::CipherText ctRead;
+  readFromFile(ctRead, "test/tmp/tmp-oneqfe-ct");
+
+  EXPECT_EQ(34, fe.Decrypt(sk, ctRead)[0]);
+  EXPECT_EQ(34, fe.DecryptFromFile(sk, "test/tmp/tmp-oneqfe-ct")[0]);
+
+  // Streams that can not seek are rejected before anything is written to them.
+  struct CountingBuf : public std::streambuf {
+    size_t written = 0;
+
+    int_type overflow(int_type c) {
+      written++;
+      return traits_type::not_eof(c);
+    }
+  } buf;
+  std::ostream unseekable(&buf);
+  EXPECT_THROW(fe.Encrypt(p.pk, x, unseekable), std::runtime_error);
+  EXPECT_EQ(0u, buf.written);
+}
+
+TEST_F(FileTest, SSDecryptBatch) {
+  Circuit *circuit = new InnerProductModPCircuit(101, {11, 2, 45, 13});
+  SS_SingletonAES fe(new InnerProductModPCircuitDescription(101, 4), 3);
+  SS_SingletonAES::KeyPair p = fe.Setup(AES_DEFAULT_KEYLENGTH);
+  SS_SingletonAES::SecretKey sk = fe.KeyGen(p.sk, circuit);
+
+  // More cipher texts than fit in one group on each thread.
+  std::vector<SS_SingletonAES::CipherText> cts;
+  for (int i = 0; i < 2 * SS_DECRYPT_BATCH_GROUP + 5; i++) {
+    cts.push_back(fe.Encrypt(p.pk, {i, 97, 3, 17}));
+  }
+
+  std::vector<std::vector<int> > pts = fe.DecryptBatch(sk, cts);
+
+  ASSERT_EQ(cts.size(), pts.size());
+  for (size_t i = 0; i < cts.size(); i++) {
+    EXPECT_EQ(fe.Decrypt(sk, cts[i]), pts[i]);
+    EXPECT_EQ((int) (11 * i + 2 * 97 + 45 * 3 + 13 * 17) % 101, pts[i][0]);
+  }
+
+  // libgarble tables are decrypted in the same groups.
+  SS_SingletonAES libgarble(new InnerProductModPCircuitDescription(101, 4), 3, GARBLING_SCHEME_LIBGARBLE_HALF_GATES);
+  cts[SS_DECRYPT_BATCH_GROUP + 1] = libgarble.Encrypt(p.pk, {5, 97, 3, 17});
+  EXPECT_EQ((11 * 5 + 2 * 97 + 45 * 3 + 13 * 17) % 101, fe.DecryptBatch(sk, cts)[SS_DECRYPT_BATCH_GROUP + 1][0]);
+
+  // Cipher texts that do not fit the circuit or key are rejected before any is decrypted.
+  cts.back().labels.push_back(cts.back().labels[0]);
+  EXPECT_THROW(fe.DecryptBatch(sk, cts), msgpack::type_error);
+  cts.back().labels.pop_back();
+
+  cts.back().inputs.pop_back();
+  cts.back().labels.push_back(cts.back().labels[0]);
+  EXPECT_THROW(fe.DecryptBatch(sk, cts), std::runtime_error);
+}
+
+TEST_F(FileTest, SSDecryptMany) {
+  std::vector<int> x = {100, 97, 3, 17};
+  SS_AES fe(new InnerProductModPCircuitDescription(101, 4), 3);
+  SS_AES::KeyPair p = fe.Setup(AES_DEFAULT_KEYLENGTH);
+  SS_AES::CipherText ct = fe.Encrypt(p.pk, x);
+
+  std::vector<SS_AES::SecretKey> sks;
+  for (int i = 0; i < 7; i++) {
+    InnerProductModPCircuit circuit(101, {i, 2 * i, 45, 13});
+    sks.push_back(fe.KeyGen(p.sk, &circuit));
+  }
+
+  std::vector<std::vector<int> > pts = fe.DecryptMany(sks, ct);
+
+  ASSERT_EQ(sks.size(), pts.size());
+  for (int i = 0; i < (int) sks.size(); i++) {
+    EXPECT_EQ(fe.Decrypt(sks[i], ct), pts[i]);
+    EXPECT_EQ((100 * i + 97 * 2 * i + 45 * 3 + 13 * 17) % 101, pts[i][0]);
+  }
+}
+
+TEST_F(FileTest, SSGarblingPool) {
+  Circuit *circuit = new InnerProductModPCircuit(101, {11, 2, 45, 13});
+  SS_AES fe(new InnerProductModPCircuitDescription(101, 4));
+  SS_AES::KeyPair p = fe.Setup(AES_DEFAULT_KEYLENGTH);
+  SS_AES::SecretKey sk = fe.KeyGen(p.sk, circuit);
+
+  fe.StartGarblingPool(p.pk, 3, 2);
+
+  // Takes more circuits than the pool holds, so some are garbled while waiting.
+  std::vector<SS_AES::CipherText> cts;
+  for (int i = 0; i < 8; i++) {
+    cts.push_back(fe.Encrypt({i, 97, 3, 17}));
+    EXPECT_EQ((11 * i + 2 * 97 + 45 * 3 + 13 * 17) % 101, fe.Decrypt(sk, cts.back())[0]);
+  }
+
+  // No garbled circuit is used twice.
+  for (size_t i = 0; i < cts.size(); i++) {
+    for (size_t j = 0; j < i; j++) {
+      EXPECT_NE(0, memcmp(&cts[i].garbled_info.global_key, &cts[j].garbled_info.global_key, sizeof(block)));
+    }
+  }
+
+  fe.StopGarblingPool();
+  EXPECT_THROW(fe.Encrypt({1, 2, 3, 4}), std::runtime_error);
+  EXPECT_THROW(fe.StartGarblingPool(p.pk, 0), std::runtime_error);
+
+  // Failures to garble are thrown by Encrypt, as RSA keys can not be derived from a seed.
+  SS_RSA rsaFe(new InnerProductModPCircuitDescription(101, 4));
+  SS_RSA::MasterPublicKey seeded;
+  seeded.seed.resize(16);
+  seeded.keyLength = 1024;
+  rsaFe.StartGarblingPool(seeded, 2);
+
+  // The failures count as ready, so waiting for the pool to fill ends.
+  while (rsaFe.GarblingPoolReady() < 2) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_THROW(rsaFe.Encrypt({1, 2, 3, 4}), std::runtime_error);
+  EXPECT_THROW(rsaFe.Encrypt({1, 2, 3, 4}), std::runtime_error);
+}
+
+TEST_F(FileTest, SSThreads) {
+  Circuit *circuit = new InnerProductModPCircuit(101, {11, 2, 45, 13});
+  std::vector<int> x = {100, 97, 3, 17};
+  CircuitDescription *desc = new InnerProductModPCircuitDescription(101, 4);
+  SS_AES fe(desc);
+  SS_AES feThreaded(desc, 4);
+  SS_AES::KeyPair p = fe.Setup(AES_DEFAULT_KEYLENGTH);
+  SS_AES::SecretKey sk = fe.KeyGen(p.sk, circuit);
+
+  std::vector<int> pt = feThreaded.Decrypt(sk, fe.Encrypt(p.pk, x));
+  std::vector<int> pt2 = fe.Decrypt(sk, feThreaded.Encrypt(p.pk, x));
+
+  EXPECT_EQ(34, pt[0]);
+  EXPECT_EQ(pt, pt2);
+}
+
+TEST_F(FileTest, SSGarblingSchemes) {
+  Circuit *circuit = new InnerProductModPCircuit(101, {11, 2, 45, 13});
+  std::vector<int> x = {100, 97, 3, 17};
+  CircuitDescription *desc = new InnerProductModPCircuitDescription(101, 4);
+
+  for (GarblingScheme scheme: {GARBLING_SCHEME_LIBGARBLE_STANDARD, GARBLING_SCHEME_LIBGARBLE_HALF_GATES}) {
+    SS_AES fe(desc, 2, scheme);
+    SS_AES::KeyPair p = fe.Setup(AES_DEFAULT_KEYLENGTH);
+    SS_AES::SecretKey sk = fe.KeyGen(p.sk, circuit);
+    SS_AES::CipherText ct = fe.Encrypt(p.pk, x);
+    SS_AES::CipherText ctRead;
+
+    EXPECT_EQ(garbledTableBlocks(desc->universalCircuitTopology(), scheme), ct.garbled_info.table.size());
+
+    writeToFile(ct, "test/tmp/tmp-oneqfe-ct");
+    readFromFile(ctRead, "test/tmp/tmp-oneqfe-ct");
+
+    EXPECT_EQ(34, fe.Decrypt(sk, ctRead)[0]);
+    EXPECT_EQ(34, fe.DecryptMany({sk}, ctRead)[0][0]);
+  }
+}
+
+TEST_F(FileTest, SSGarbledTableChecks) {
+  Circuit *circuit = new InnerProductModPCircuit(101, {11, 2, 45, 13});
+  std::vector<int> x = {100, 97, 3, 17};
+  CircuitDescription *desc = new InnerProductModPCircuitDescription(101, 4);
+
+  SS_AES fe(desc, 2, GARBLING_SCHEME_LIBGARBLE_STANDARD);
+  SS_AES::KeyPair p = fe.Setup(AES_DEFAULT_KEYLENGTH);
+  SS_AES::SecretKey sk = fe.KeyGen(p.sk, circuit);
+  SS_AES::CipherText ct = fe.Encrypt(p.pk, x);
+
+  // Tables and output permutation bits that do not fit the circuit are rejected, rather than read past.
+  SS_AES::CipherText shortTable = ct;
+  shortTable.garbled_info.table.pop_back();
+  EXPECT_THROW(fe.Decrypt(sk, shortTable), msgpack::type_error);
+  EXPECT_THROW(fe.DecryptMany({sk}, shortTable), msgpack::type_error);
+
+  SS_AES::CipherText shortPerms = ct;
+  shortPerms.garbled_info.output_perms.pop_back();
+  EXPECT_THROW(fe.Decrypt(sk, shortPerms), msgpack::type_error);
+
+  // Version 0 tables are checked against the legacy universal circuit, which only older types of circuits have.
+  SS_AES::CipherText oldVersion = ct;
+  oldVersion.garbled_info.version = GARBLED_INFO_VERSION_LIBGARBLE;
+  EXPECT_THROW(fe.Decrypt(sk, oldVersion), msgpack::type_error);
+
+  BandedLevenshteinCircuitDescription banded(4, 4, 2, 1);
+  EXPECT_THROW(banded.legacyUniversalCircuitTopology(), std::runtime_error);
+
+  SS_AES halfGates(desc, 2);
+  SS_AES::CipherText compact = halfGates.Encrypt(p.pk, x);
+  compact.garbled_info.output_perms.pop_back();
+  EXPECT_THROW(halfGates.Decrypt(sk, compact), std::runtime_error);
+}
+
+// Encrypts msg to fileName as SS did before the gadgets were reworked: the legacy universal circuit is garbled with
+// libgarble's half-gates, and the cipher text is packed in the original layout, with a two element GarbledInfo.
+static void baselineEncrypt(CircuitDescription *desc, SS_AES::MasterPublicKey &mpk, std::vector<int> msg,
+                            std::string fileName) {
+  const garble_circuit *legacy = desc->legacyUniversalCircuitTopology();
+  garble_circuit circuit = *legacy;
+  circuit.gates = (garble_gate *) malloc(legacy->q * sizeof(garble_gate));
+  memcpy(circuit.gates, legacy->gates, legacy->q * sizeof(garble_gate));
+  circuit.outputs = (int *) malloc(legacy->m * sizeof(int));
+  memcpy(circuit.outputs, legacy->outputs, legacy->m * sizeof(int));
+  circuit.wires = NULL;
+  circuit.table = NULL;
+  circuit.output_perms = NULL;
+  garble_garble(&circuit, NULL, NULL);
+
+  GarbledInfo info;
+  info.packTable(&circuit);
+
+  std::ofstream file(fileName, std::ios::out | std::ios::binary);
+  msgpack::packer<std::ostream> pk(file);
+  pk.pack_array(3);
+
+  pk.pack_array(2);
+  pk.pack_array(circuit.m);
+  for (size_t i = 0; i < circuit.m; i++) {
+    if (circuit.output_perms[i]) {
+      pk.pack_true();
+    } else {
+      pk.pack_false();
+    }
+  }
+  pk.pack_bin((info.table.size() + 2) * sizeof(block));
+  pk.pack_bin_body((const char *) info.table.data(), info.table.size() * sizeof(block));
+  pk.pack_bin_body((const char *) &circuit.fixed_label, sizeof(block));
+  pk.pack_bin_body((const char *) &circuit.global_key, sizeof(block));
+
+  std::vector<block> labels(desc->input_size);
+  for (int i = 0; i < desc->input_size; i++) {
+    labels[i] = circuit.wires[2 * i + desc->msgBit(msg, i)];
+  }
+  pk.pack_bin(labels.size() * sizeof(block));
+  pk.pack_bin_body((const char *) labels.data(), labels.size() * sizeof(block));
+
+  pk.pack_array(desc->circuit_size * 2);
+  for (int i = 0; i < desc->circuit_size; i++) {
+    const unsigned char *bytes1 = (const unsigned char*) &circuit.wires[2 * i + 2 * desc->input_size];
+    const unsigned char *bytes2 = (const unsigned char*) &circuit.wires[2 * i + 1 + 2 * desc->input_size];
+    AES::Encrypt(mpk.pks[i].first, AES::PlainText(bytes1, bytes1 + 16)).msgpack_pack(pk);
+    AES::Encrypt(mpk.pks[i].second, AES::PlainText(bytes2, bytes2 + 16)).msgpack_pack(pk);
+  }
+
+  file.close();
+  garble_delete(&circuit);
+}
+
+TEST_F(FileTest, SSBaselineCipherText) {
+  Circuit *circuit = new InnerProductModPCircuit(101, {11, 2, 45, 13});
+  std::vector<int> x = {100, 97, 3, 17};
+  CircuitDescription *desc = new InnerProductModPCircuitDescription(101, 4);
+
+  SS_AES fe(desc, 2);
+  SS_AES::KeyPair p = fe.Setup(AES_DEFAULT_KEYLENGTH);
+  SS_AES::SecretKey sk = fe.KeyGen(p.sk, circuit);
+
+  // Garbled tables depend on the libgarble build, so the cipher text is made here rather than kept as a file.
+  baselineEncrypt(desc, p.pk, x, "test/tmp/tmp-oneqfe-baseline-ct");
+
+  SS_AES::CipherText ctRead;
+  readFromFile(ctRead, "test/tmp/tmp-oneqfe-baseline-ct");
+  EXPECT_EQ(GARBLED_INFO_VERSION_LIBGARBLE, ctRead.garbled_info.version);
+
+  EXPECT_EQ(34, fe.Decrypt(sk, ctRead)[0]);
+  EXPECT_EQ(34, fe.DecryptFromFile(sk, "test/tmp/tmp-oneqfe-baseline-ct")[0]);
+  EXPECT_EQ(34, fe.DecryptBatch(sk, {ctRead, ctRead})[1][0]);
+  EXPECT_EQ(34, fe.DecryptMany({sk, sk}, ctRead)[1][0]);
+
+  // Writing it again keeps the original layout.
+  writeToFile(ctRead, "test/tmp/tmp-oneqfe-ct");
+  std::ifstream original("test/tmp/tmp-oneqfe-baseline-ct", std::ios::binary);
+  std::ifstream rewritten("test/tmp/tmp-oneqfe-ct", std::ios::binary);
+  EXPECT_EQ(std::string(std::istreambuf_iterator<char>(original), std::istreambuf_iterator<char>()),
+            std::string(std::istreambuf_iterator<char>(rewritten), std::istreambuf_iterator<char>()));
+}
+
+TEST_F(FileTest, SSSeededKeys) {
+  Circuit *circuit = new InnerProductModPCircuit(101, {11, 2, 45, 13});
+  std::vector<int> x = {100, 97, 3, 17};
+  CircuitDescription *desc = new InnerProductModPCircuitDescription(101, 4);
+
+  SS_AES fe(desc, 2, GARBLING_SCHEME_HALF_GATES, true);
+  SS_AES::KeyPair p = fe.Setup(AES_DEFAULT_KEYLENGTH);
+  SS_AES::MasterSecretKey mskRead;
+  SS_AES::MasterPublicKey mpkRead;
+
+  // Only the seed is kept, rather than a key per input bit.
+  EXPECT_TRUE(p.sk.sks.empty());
+  EXPECT_EQ(16, p.sk.seed.size());
+  EXPECT_EQ(p.sk.seed, p.pk.seed);
+
+  writeToFile(p.sk, "test/tmp/tmp-oneqfe-msk");
+  readFromFile(mskRead, "test/tmp/tmp-oneqfe-msk");
+  writeToFile(p.pk, "test/tmp/tmp-oneqfe-mpk");
+  readFromFile(mpkRead, "test/tmp/tmp-oneqfe-mpk");
+
+  SS_AES::SecretKey sk = fe.KeyGen(mskRead, circuit);
+  SS_AES::CipherText ct = fe.Encrypt(mpkRead, x);
+  EXPECT_EQ(34, fe.Decrypt(sk, ct)[0]);
+
+  SS_SingletonAES singletonFe(desc, 1, GARBLING_SCHEME_HALF_GATES, true);
+  SS_SingletonAES::KeyPair singletonP = singletonFe.Setup(AES_DEFAULT_KEYLENGTH);
+  SS_SingletonAES::SecretKey singletonSk = singletonFe.KeyGen(singletonP.sk, circuit);
+  EXPECT_EQ(34, singletonFe.Decrypt(singletonSk, singletonFe.Encrypt(singletonP.pk, x))[0]);
+
+  // Batches derive the same keys as Derive, one at a time.
+  std::vector<uint64_t> indices = {5, 0, 12, 5};
+  std::vector<AES::KeyPair> pairs;
+  AES::DeriveBatch(p.sk.seed, 32, indices.data(), indices.size(), pairs);
+  ASSERT_EQ(indices.size(), pairs.size());
+  for (size_t i = 0; i < indices.size(); i++) {
+    AES::KeyPair single = AES::Derive(p.sk.seed, 32, indices[i]);
+    ASSERT_EQ(32, pairs[i].sk.key.size());
+    EXPECT_EQ(0, memcmp(single.sk.key.data(), pairs[i].sk.key.data(), 32));
+  }
+
+  // RSA keys can not be derived from a seed.
+  SS_RSA rsaFe(desc, 1, GARBLING_SCHEME_HALF_GATES, true);
+  EXPECT_THROW(rsaFe.Setup(1024), std::runtime_error);
+}
+
+TEST_F(FileTest, GarbledInfoVersions) {
+  GarbledInfo info;
+  info.fixed_label = _mm_set_epi64x(1, 2);
+  info.global_key = _mm_set_epi64x(3, 4);
+  for (int i = 0; i < 13; i++) {
+    info.output_perms.push_back(i % 3 == 0);
+  }
+  for (int i = 0; i < 6; i++) {
+    info.table.push_back(_mm_set_epi64x(i, 100 + i));
+  }
+
+  // Older versions must stay readable.
+  for (int version: {GARBLED_INFO_VERSION_LIBGARBLE, GARBLED_INFO_VERSION_HALF_GATES, GARBLED_INFO_VERSION_COMPACT,
+                     GARBLED_INFO_VERSION_LIBGARBLE_TYPED}) {
+    GarbledInfo infoRead;
+    info.version = version;
+    info.garbleType = version == GARBLED_INFO_VERSION_LIBGARBLE_TYPED ? GARBLE_TYPE_STANDARD : GARBLE_TYPE_HALFGATES;
+
+    writeToFile(info, "test/tmp/tmp-garbled-info");
+    readFromFile(infoRead, "test/tmp/tmp-garbled-info");
+
+    EXPECT_EQ(version, infoRead.version);
+    EXPECT_EQ(info.garbleType, infoRead.garbleType);
+    EXPECT_EQ(info.output_perms, infoRead.output_perms);
+    ASSERT_EQ(info.table.size(), infoRead.table.size());
+    for (size_t i = 0; i < info.table.size(); i++) {
+      EXPECT_EQ_BLOCKS(info.table[i], infoRead.table[i]);
+    }
+    EXPECT_EQ_BLOCKS(info.fixed_label, infoRead.fixed_label);
+    EXPECT_EQ_BLOCKS(info.global_key, infoRead.global_key);
+  }
+
+  // Only the libgarble types SS garbles with are read.
+  for (int garbleType: {(int) GARBLE_TYPE_PRIVACY_FREE, 17}) {
+    GarbledInfo infoRead;
+    info.version = GARBLED_INFO_VERSION_LIBGARBLE_TYPED;
+    info.garbleType = garbleType;
+    writeToFile(info, "test/tmp/tmp-garbled-info");
+    EXPECT_THROW(readFromFile(infoRead, "test/tmp/tmp-garbled-info"), msgpack::type_error);
+  }
+}
+
 TEST_F(FileTest, GVWKeys) {
   Circuit *circuit = new InnerProductModPCircuit(101, {11, 2, 45, 13});
   std::vector<int> x = {100, 97, 3, 17};
@@ -165,6 +762,10 @@ TEST_F(FileTest, GVWKeysDelta) {
   Circuit *circuit = new InnerProductModPCircuit(101, {11, 2, 45, 13});
   std::vector<int> x = {100, 97, 3, 17};
   GVW<SS_AES> fe(2, 2, 1, 101, true, new InnerProductModPCircuitDescription(101, 4));
+
+  // Each share garbles the circuit with Delta added.
+  EXPECT_EQ(CIRCUIT_TYPE_INNER_PRODUCT_MOD_P_DELTA, fe.oneQueryCircuitDescription()->type);
+
   GVW<SS_AES>::KeyPair p = fe.Setup(AES_DEFAULT_KEYLENGTH);
   GVW<SS_AES>::SecretKey sk = fe.KeyGen(p.sk, circuit);
   GVW<SS_AES>::CipherText ct = fe.Encrypt(p.pk, x);
@@ -207,6 +808,10 @@ TEST_F(FileTest, GVWSecretKey) {
 
   EXPECT_EQ(34, pt[0]);
   EXPECT_EQ(pt, pt2);
+  ASSERT_EQ(sk.sks.size(), skRead.sks.size());
+  for (size_t i = 0; i < sk.sks.size(); i++) {
+    EXPECT_EQ(sk.sks[i].bits, skRead.sks[i].bits);
+  }
 }
 
 TEST_F(FileTest, GVWCipherText) {
@@ -228,3 +833,17 @@ TEST_F(FileTest, GVWCipherText) {
   EXPECT_EQ(34, pt[0]);
   EXPECT_EQ(pt, pt2);
 }
+
+TEST_F(FileTest, GVWGarblingOptions) {
+  Circuit *circuit = new InnerProductModPCircuit(101, {11, 2, 45, 13});
+  std::vector<int> x = {100, 97, 3, 17};
+
+  // The threads and garbling scheme are those of the SS instance for every share.
+  GVW<SS_AES> fe(2, 2, 1, 101, true, new InnerProductModPCircuitDescription(101, 4), 2, GARBLING_SCHEME_LIBGARBLE_HALF_GATES);
+  GVW<SS_AES>::KeyPair p = fe.Setup(AES_DEFAULT_KEYLENGTH);
+  GVW<SS_AES>::SecretKey sk = fe.KeyGen(p.sk, circuit);
+  GVW<SS_AES>::CipherText ct = fe.Encrypt(p.pk, x);
+
+  EXPECT_EQ(GARBLED_INFO_VERSION_LIBGARBLE_TYPED, ct.cts[0].garbled_info.version);
+  EXPECT_EQ(34, fe.Decrypt(sk, ct)[0]);
+}
@@ -0,0 +1,170 @@
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <sstream>
+
+#include "circuit/circuit.h"
+#include "circuit/circuit_utils.h"
+#include "libgarble/garble.h"
+#include "libgarble/circuit_builder.h"
+#include "libgarble/garbled_info.h"
+#include "libgarble/half_gates.h"
+
+#include "gtest/gtest.h"
+
+class HalfGatesTest : public testing::Test {
+ protected:
+  void SetUp() {
+    int n = 8, m = 10;
+    std::vector<int> inp(n), outputs(m);
+
+    garble_new(&gc, n, m, GARBLE_TYPE_HALFGATES);
+    builder_init_wires(inp.data(), n);
+    builder_start_building(&gc, &ctxt);
+
+    // Covers AND, OR, XOR and free NOT gates, and outputs on the constant wires.
+    add(&gc, &ctxt, inp.data(), inp.data() + 4, outputs.data(), 4);
+    neq(&gc, &ctxt, inp.data(), inp.data() + 4, &outputs[5], 4);
+    gteq(&gc, &ctxt, inp.data(), inp.data() + 4, &outputs[6], 4);
+    outputs[7] = gateNOT(&gc, &ctxt, inp[0]);
+    outputs[8] = wire_zero(&gc);
+    outputs[9] = wire_one(&gc);
+
+    builder_finish_building(&gc, &ctxt, outputs.data());
+  }
+
+  void TearDown() {
+    garble_delete(&gc);
+  }
+
+  std::vector<int> eval(int a, int b) {
+    GarbledInfo info;
+    std::vector<block> inputLabels, labels(gc.n);
+    bool vals[10];
+
+    halfGatesGarble(&gc, inputLabels, info);
+
+    for (int i = 0; i < 4; i++) {
+      labels[i] = inputLabels[2 * i + ((a >> i) & 1)];
+      labels[i + 4] = inputLabels[2 * (i + 4) + ((b >> i) & 1)];
+    }
+
+    halfGatesEval(&gc, labels.data(), info, vals);
+
+    return std::vector<int>(vals, vals + 10);
+  }
+
+  garble_circuit gc;
+  garble_context ctxt;
+};
+
+TEST_F(HalfGatesTest, allInputs) {
+  for (int a = 0; a < 16; a++) {
+    for (int b = 0; b < 16; b++) {
+      std::vector<int> vals = eval(a, b);
+
+      int sum = 0;
+      for (int i = 4; i >= 0; i--) {
+        sum = 2 * sum + vals[i];
+      }
+
+      EXPECT_EQ(a + b, sum);
+      EXPECT_EQ(a != b, vals[5]);
+      EXPECT_EQ(a >= b, vals[6]);
+      EXPECT_EQ(1 - (a & 1), vals[7]);
+      EXPECT_EQ(0, vals[8]);
+      EXPECT_EQ(1, vals[9]);
+    }
+  }
+}
+
+TEST_F(HalfGatesTest, onlyANDAndORRows) {
+  GarbledInfo info;
+  std::vector<block> inputLabels;
+
+  halfGatesGarble(&gc, inputLabels, info);
+
+  size_t rows = 0;
+  for (size_t i = 0; i < gc.q; i++) {
+    if (gc.gates[i].type == GARBLE_GATE_AND || gc.gates[i].type == GARBLE_GATE_OR) {
+      rows++;
+    }
+  }
+
+  EXPECT_EQ(rows * HALF_GATES_ROW_BLOCKS, info.table.size());
+  EXPECT_EQ(2 * gc.n, inputLabels.size());
+  EXPECT_EQ(gc.m, info.output_perms.size());
+}
+
+TEST_F(HalfGatesTest, streamedRows) {
+  GarbledInfo info;
+  std::vector<block> inputLabels, labels(gc.n);
+  bool vals[10], streamedVals[10];
+
+  halfGatesGarble(&gc, inputLabels, info);
+  for (size_t i = 0; i < gc.n; i++) {
+    labels[i] = inputLabels[2 * i + (i % 3 == 0)];
+  }
+  halfGatesEval(&gc, labels.data(), info, vals);
+
+  // Chunks that do not divide the number of rows.
+  std::stringstream table(std::string((const char *) info.table.data(), info.table.size() * sizeof(block)));
+  StreamRowSource rows(table, info.table.size() / HALF_GATES_ROW_BLOCKS, 3);
+  WireSlots wireSlots;
+  assignWireSlots(&gc, wireSlots);
+  halfGatesEval(&gc, wireSlots, labels.data(), info, rows, streamedVals);
+
+  EXPECT_EQ(std::vector<bool>(vals, vals + 10), std::vector<bool>(streamedVals, streamedVals + 10));
+
+  // A table that ends early is rejected.
+  std::stringstream shortTable(table.str().substr(sizeof(block)));
+  StreamRowSource shortRows(shortTable, info.table.size() / HALF_GATES_ROW_BLOCKS, 3);
+  EXPECT_THROW(halfGatesEval(&gc, wireSlots, labels.data(), info, shortRows, streamedVals), std::runtime_error);
+}
+
+TEST(WireSlotsTest, levenshtein) {
+  int len = 12, bits = 2;
+  LevenshteinCircuitDescription desc(len, len, bits);
+  const garble_circuit *topology = desc.universalCircuitTopology();
+  const WireSlots &wireSlots = desc.universalCircuitWireSlots();
+
+  // Only a row of the table is live at a time, rather than every cell.
+  EXPECT_LT(wireSlots.count * 4, topology->r);
+
+  for (int trial = 0; trial < 5; trial++) {
+    std::vector<int> a(len), b(len);
+    for (int i = 0; i < len; i++) {
+      a[i] = rand() % (1 << bits);
+      b[i] = rand() % (1 << bits);
+    }
+
+    GarbledInfo info;
+    std::vector<block> inputLabels, labels(topology->n);
+    bool outputs[topology->m];
+
+    halfGatesGarble(topology, inputLabels, info);
+    for (int i = 0; i < len * bits; i++) {
+      labels[i] = inputLabels[2 * i + desc.msgBit(a, i)];
+      labels[i + len * bits] = inputLabels[2 * (i + len * bits) + desc.msgBit(b, i)];
+    }
+    halfGatesEval(topology, wireSlots, labels.data(), info, outputs);
+
+    std::vector<std::vector<int> > d(len + 1, std::vector<int>(len + 1));
+    for (int i = 0; i <= len; i++) {
+      for (int j = 0; j <= len; j++) {
+        if (i == 0 || j == 0) {
+          d[i][j] = i + j;
+        } else {
+          d[i][j] = std::min(std::min(d[i-1][j], d[i][j-1]) + 1, d[i-1][j-1] + (a[i-1] != b[j-1]));
+        }
+      }
+    }
+
+    int z = 0;
+    for (int i = topology->m - 1; i >= 0; i--) {
+      z = 2 * z + outputs[i];
+    }
+
+    EXPECT_EQ(d[len][len], z);
+  }
+}
@@ -2,9 +2,11 @@
 #include <iostream>
 #include <cstdlib>
 
+#include "circuit/circuit.h"
 #include "circuit/hamming_circuit.h"
 #include "libgarble/garble.h"
 #include "libgarble/circuit_builder.h"
+#include "libgarble/garbled_info.h"
 
 #include "gtest/gtest.h"
 
@@ -150,3 +152,24 @@ TEST_F(CircuitTest, hamming4) {
 
   EXPECT_EQ(expected, z);
 }
+
+TEST(HammingStatisticsTest, statistics) {
+  HammingCircuitDescription desc(100);
+  CircuitStatistics stats = desc.statistics();
+  garble_circuit *topology = (garble_circuit *) desc.universalCircuitTopology();
+
+  EXPECT_EQ(numNonXOR(topology), stats.nonXOR());
+  EXPECT_EQ(topology->q, stats.andGates + stats.orGates + stats.xorGates + stats.notGates + stats.constantGates);
+  EXPECT_EQ(topology->r, stats.wires);
+
+  // Every AND gate is in a full adder of the popcount, and the 100 input XORs are outside it.
+  EXPECT_EQ(1u, stats.gadgets["hamming"].calls);
+  EXPECT_EQ(stats.andGates, stats.gadgets["popcount"].andGates);
+  EXPECT_EQ(stats.andGates, stats.gadgets["fullAdder"].andGates);
+  EXPECT_EQ(stats.xorGates, stats.gadgets["hamming"].xorGates);
+  EXPECT_EQ(stats.xorGates - 100, stats.gadgets["popcount"].xorGates);
+  EXPECT_EQ(0u, stats.gadgets.count("other"));
+
+  EXPECT_GT(stats.multiplicativeDepth, 0);
+  EXPECT_LT(stats.multiplicativeDepth, 100);
+}
@@ -3,6 +3,7 @@
 #include <cstdlib>
 
 #include "circuit/inner_product_circuit.h"
+#include "circuit/add_delta.h"
 #include "libgarble/garble.h"
 #include "libgarble/circuit_builder.h"
 
@@ -65,6 +66,46 @@ TEST_F(InnerProductCircuitTest, innerProductCircuit) {
   EXPECT_EQ(0, (int) vals[3]);
 }
 
+TEST_F(InnerProductCircuitTest, innerProductCircuitWide) {
+  int m = 13, numbers = 10, n = m * numbers;
+  long long mod = 8191, expected = 0;
+  std::vector<int> input(2 * n);
+
+  for (int i = 0; i < numbers; i++) {
+    long long x = (i * 2731 + 8000) % mod, y = (i * 977 + 8190) % mod;
+    expected = (expected + x * y) % mod;
+    for (int j = 0; j < m; j++) {
+      input[i * m + j] = (x >> j) & 1;
+      input[n + i * m + j] = (y >> j) & 1;
+    }
+  }
+
+  start(2 * n, m);
+  innerProductCircuit(gc, ctxt, n, n, inp, outputs, m, mod);
+  finishGarbleAndEval(2 * n, m, input);
+
+  long long z = 0;
+  for (int i = m - 1; i >= 0; i--) {
+    z = 2 * z + vals[i];
+  }
+
+  EXPECT_EQ(expected, z);
+}
+
+TEST_F(InnerProductCircuitTest, addDelta) {
+  int m = 4, poolSize = 3, n = m + poolSize * m + poolSize;
+
+  start(n, m);
+  addDelta(gc, ctxt, poolSize, inp, inp + m, inp + m + poolSize * m, outputs, m, 11);
+  // 7 + 9 + 10 (the second entry of the pool, 6, is not selected) = 26 = 4 mod 11
+  finishGarbleAndEval(n, m, {1,1,1,0, 1,0,0,1, 0,1,1,0, 0,1,0,1, 1,0,1});
+
+  EXPECT_EQ(0, (int) vals[0]);
+  EXPECT_EQ(0, (int) vals[1]);
+  EXPECT_EQ(1, (int) vals[2]);
+  EXPECT_EQ(0, (int) vals[3]);
+}
+
 TEST_F(InnerProductCircuitTest, innerProductCircuit32) {
   int n = 64, m = 32;
 
@@ -198,3 +198,158 @@ TEST_F(LevenshteinTest, 2bitsLarge) {
     z += vals[i];
   }
 }
+
+// Plain levenshtein distance between two strings of characters, for checking the circuits against.
+static int levenshteinDistance(const std::vector<int> &a, const std::vector<int> &b) {
+  std::vector<std::vector<int> > d(a.size() + 1, std::vector<int>(b.size() + 1));
+
+  for (size_t i = 0; i <= a.size(); i++) {
+    for (size_t j = 0; j <= b.size(); j++) {
+      if (i == 0 || j == 0) {
+        d[i][j] = i + j;
+      } else {
+        d[i][j] = std::min(std::min(d[i-1][j], d[i][j-1]) + 1, d[i-1][j-1] + (a[i-1] != b[j-1]));
+      }
+    }
+  }
+
+  return d[a.size()][b.size()];
+}
+
+TEST_F(LevenshteinTest, 1bit_edge_of_table) {
+  int len1 = 3, len2 = 7;
+  int n = len1 + len2, m = 3;
+
+  start(n, m);
+  levenshteinCircuit(gc, ctxt, inp, outputs, len1, len2, 1);
+  finishGarbleAndEval(n, m, {0,0,0, 1,1,1,1,1,1,1});
+
+  int z = 0;
+
+  for (int i = m - 1; i >= 0; i--) {
+    z *= 2;
+    z += vals[i];
+  }
+
+  EXPECT_EQ(7, z);
+}
+
+TEST_F(LevenshteinTest, diff) {
+  int len1 = 40, len2 = 23;
+  int alphabetBits = 2;
+  int n = (len1 + len2) * alphabetBits, m = (int) ceil(log2(std::max(len1, len2) + 1));
+
+  start(n, m);
+  levenshteinDiffCircuit(gc, ctxt, inp, outputs, len1, len2, alphabetBits);
+
+  for (int trial = 0; trial < 4; trial++) {
+    std::vector<int> a(len1), b(len2), inputs(n);
+
+    for (int i = 0; i < len1; i++) {
+      a[i] = rand() % 4;
+    }
+    for (int i = 0; i < len2; i++) {
+      b[i] = (rand() % (trial + 2) == 0) ? rand() % 4 : a[2 * i % len1];
+    }
+    for (int i = 0; i < len1 + len2; i++) {
+      int c = i < len1 ? a[i] : b[i - len1];
+      inputs[i * alphabetBits] = c % 2;
+      inputs[i * alphabetBits + 1] = c / 2;
+    }
+
+    if (trial == 0) {
+      finishGarbleAndEval(n, m, inputs);
+    } else {
+      std::vector<block> extractedLabels(n);
+      for (int i = 0; i < n; i++) {
+        extractedLabels[i] = gc->wires[2*i+inputs[i]];
+      }
+      garble_eval(gc, extractedLabels.data(), NULL, vals);
+    }
+
+    int z = 0;
+
+    for (int i = m - 1; i >= 0; i--) {
+      z *= 2;
+      z += vals[i];
+    }
+
+    EXPECT_EQ(levenshteinDistance(a, b), z);
+  }
+}
+
+TEST_F(LevenshteinTest, diff_1bit_edge_of_table) {
+  int len1 = 3, len2 = 7;
+  int n = len1 + len2, m = 3;
+
+  start(n, m);
+  levenshteinDiffCircuit(gc, ctxt, inp, outputs, len1, len2, 1);
+  finishGarbleAndEval(n, m, {0,0,0, 1,1,1,1,1,1,1});
+
+  int z = 0;
+
+  for (int i = m - 1; i >= 0; i--) {
+    z *= 2;
+    z += vals[i];
+  }
+
+  EXPECT_EQ(7, z);
+}
+
+TEST_F(LevenshteinTest, banded) {
+  int len1 = 30, len2 = 26, threshold = 6;
+  int alphabetBits = 2;
+  int n = (len1 + len2) * alphabetBits, m = (int) ceil(log2(threshold + 2));
+
+  start(n, m);
+  bandedLevenshteinCircuit(gc, ctxt, inp, outputs, len1, len2, alphabetBits, threshold);
+
+  for (int trial = 0; trial < 4; trial++) {
+    std::vector<int> a(len1), b(len2), inputs(n);
+
+    // Start from similar strings, so that both sides of the threshold are tested.
+    for (int i = 0; i < len1; i++) {
+      a[i] = rand() % 4;
+    }
+    for (int i = 0; i < len2; i++) {
+      b[i] = (rand() % (trial + 2) == 0) ? rand() % 4 : a[i + (len1 - len2) / 2];
+    }
+    for (int i = 0; i < len1 + len2; i++) {
+      int c = i < len1 ? a[i] : b[i - len1];
+      inputs[i * alphabetBits] = c % 2;
+      inputs[i * alphabetBits + 1] = c / 2;
+    }
+
+    if (trial == 0) {
+      finishGarbleAndEval(n, m, inputs);
+    } else {
+      std::vector<block> extractedLabels(n);
+      for (int i = 0; i < n; i++) {
+        extractedLabels[i] = gc->wires[2*i+inputs[i]];
+      }
+      garble_eval(gc, extractedLabels.data(), NULL, vals);
+    }
+
+    int z = 0;
+
+    for (int i = m - 1; i >= 0; i--) {
+      z *= 2;
+      z += vals[i];
+    }
+
+    EXPECT_EQ(std::min(levenshteinDistance(a, b), threshold + 1), z);
+  }
+}
+
+TEST_F(LevenshteinTest, bandedOutsideThreshold) {
+  int len1 = 10, len2 = 4, threshold = 3;
+  int n = len1 + len2, m = 3;
+
+  start(n, m);
+  bandedLevenshteinCircuit(gc, ctxt, inp, outputs, len1, len2, 1, threshold);
+  finishGarbleAndEval(n, m, std::vector<int>(n, 1));
+
+  EXPECT_EQ(0, (int) vals[0]);
+  EXPECT_EQ(0, (int) vals[1]);
+  EXPECT_EQ(1, (int) vals[2]);
+}
@@ -0,0 +1,38 @@
+#include <vector>
+#include <thread>
+#include <algorithm>
+
+#include "util/random.h"
+
+#include "gtest/gtest.h"
+
+TEST(RandomTest, streams) {
+  // Requests that cross refills of the buffer.
+  std::vector<unsigned char> a(5000), b(5000);
+  threadRandom().GenerateBlock(a.data(), 7);
+  threadRandom().GenerateBlock(a.data() + 7, a.size() - 7);
+
+  std::thread other([&b] { threadRandom().GenerateBlock(b.data(), b.size()); });
+  other.join();
+
+  // Each thread has its own stream, and no output repeats.
+  EXPECT_NE(a, b);
+  for (size_t i = 16; i < a.size(); i += 16) {
+    EXPECT_FALSE(std::equal(a.begin(), a.begin() + 16, a.begin() + i));
+  }
+}
+
+TEST(RandomTest, uniform) {
+  std::vector<int> counts(5);
+
+  for (int i = 0; i < 5000; i++) {
+    uint64_t x = threadRandom().uniform(5);
+    ASSERT_LT(x, 5u);
+    counts[x]++;
+  }
+
+  for (int count: counts) {
+    EXPECT_GT(count, 800);
+    EXPECT_LT(count, 1200);
+  }
+}